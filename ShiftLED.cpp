@@ -2,32 +2,283 @@
 
 #include "ShiftLED.h"
 
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+// Nibble-to-SPI-pattern tables. Each LED data bit expands to a fixed SPI bit pattern,
+// so a byte is encoded with two table lookups instead of eight separate transfers.
+// The 8-bit table is built per strip from the chip's timing profile.
+
+// 4 SPI bits per LED bit: one = 0b1110, zero = 0b1000
+const uint16_t ShiftLED::encodeTable4Bit[16] = {
+    0x8888, 0x888E, 0x88E8, 0x88EE, 0x8E88, 0x8E8E, 0x8EE8, 0x8EEE,
+    0xE888, 0xE88E, 0xE8E8, 0xE8EE, 0xEE88, 0xEE8E, 0xEEE8, 0xEEEE
+};
+
+// 3 SPI bits per LED bit: one = 0b110, zero = 0b100 (12 bits per nibble)
+const uint16_t ShiftLED::encodeTable3Bit[16] = {
+    0x924, 0x926, 0x934, 0x936, 0x9A4, 0x9A6, 0x9B4, 0x9B6,
+    0xD24, 0xD26, 0xD34, 0xD36, 0xDA4, 0xDA6, 0xDB4, 0xDB6
+};
+
+// 65536 * 31 / (level * 255): brightness * entry >> 8 is the color scale left after the hardware level
+const uint16_t ShiftLED::hardwareBrightnessScale[32] = {
+    0,   7967, 3983, 2655, 1991, 1593, 1327, 1138, 995, 885, 796, 724, 663, 612, 569, 531,
+    497, 468,  442,  419,  398,  379,  362,  346,  331, 318, 306, 295, 284, 274, 265, 257
+};
+
+// Known chips. At 8 MHz one SPI bit is 125 ns, so 0xF8 is a 625 ns pulse and 0xC0 a 250 ns pulse.
+// The first entry is used for plain color order strings.
+struct ChipType {
+    LEDTimingProfile timing;
+    const char* colorOrder;
+    SPIEncoding encoding;
+};
+
+static const ChipType chipTypes[] = {
+    {{"WS2812",     8000000,  0xF8, 0xC0, 300}, "GRB",  SPI_ENCODING_8BIT},  // Covers the 50 µs and 280 µs revisions
+    {{"NEOPIXEL",   8000000,  0xF8, 0xC0, 300}, "GRB",  SPI_ENCODING_8BIT},
+    {{"WS2812B",    8000000,  0xFC, 0xE0, 280}, "GRB",  SPI_ENCODING_8BIT},  // T0H 400 ns, T1H 800 ns
+    {{"WS2811",     8000000,  0xF8, 0xC0, 280}, "RGB",  SPI_ENCODING_8BIT},  // 800 kHz mode
+    {{"WS2813",     8000000,  0xFC, 0xE0, 280}, "GRB",  SPI_ENCODING_8BIT},
+    {{"WS2815",     8000000,  0xF8, 0xC0, 280}, "GRB",  SPI_ENCODING_8BIT},
+    {{"SK6812",     8000000,  0xF8, 0xC0, 80},  "GRB",  SPI_ENCODING_8BIT},  // T0H 300 ns, T1H 600 ns
+    {{"SK6812RGBW", 8000000,  0xF8, 0xC0, 80},  "GRBW", SPI_ENCODING_8BIT},
+    {{"APA102",     20000000, 0x00, 0x00, 0},   "BGR",  SPI_ENCODING_APA102}, // Clocked; latched by the end frame
+    {{"SK9822",     15000000, 0x00, 0x00, 0},   "BGR",  SPI_ENCODING_APA102}
+};
+
+// Pipeline state: index of the newest published frame, and a flag set until the output side takes it
+static const uint8_t PIPELINE_FRAME_MASK = 0x03;
+static const uint8_t PIPELINE_FRESH = 0x04;
+
 ///---------------------------------------------------------------------------------------------------------------------
 /// @brief Constructor for ShiftLED class.
 ///
-ShiftLED::ShiftLED(String ledTypeString, uint16_t numLEDs, uint8_t dataPin, SPIClass& SPI_peripheral)
-    : numLEDs(numLEDs), dataPin(dataPin), SPI_peripheral(SPI_peripheral), desiredGlobalBrightness(255),
-      actualGlobalBrightness(255), maxAllowedPower_mW(0), maxPowerPerLED_mW(300) { // Default maxPowerPerLED_mW is 300
+ShiftLED::ShiftLED(String ledTypeString, uint32_t numLEDs, uint8_t dataPin, SPIClass& SPI_peripheral)
+    : ShiftLED(ledTypeString, numLEDs, dataPin, SPI_peripheral, nullptr) {}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Constructor for caller-provided buffers; the strip never allocates its LED or wire storage.
+///
+ShiftLED::ShiftLED(String ledTypeString, uint32_t numLEDs, uint8_t dataPin, const ShiftLEDBuffers& buffers,
+                   SPIClass& SPI_peripheral)
+    : ShiftLED(ledTypeString, numLEDs, dataPin, SPI_peripheral, &buffers) {}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Constructor shared by the type string constructors.
+///
+ShiftLED::ShiftLED(String ledTypeString, uint32_t numLEDs, uint8_t dataPin, SPIClass& SPI_peripheral,
+                   const ShiftLEDBuffers* buffers)
+    : ShiftLED(numLEDs, dataPin, SPI_peripheral) {
     // Parse the LED type and set configurations
     if (!parseLEDType(ledTypeString)) {
         Serial.println("Unsupported LED type. Please check the LED type string.");
     }
 
-    // Allocate memory for LED data and brightness
-    size_t colorComponentCount = colorOrder.size();
-    this->ledData = new uint8_t[numLEDs * colorComponentCount];
-    this->ledBrightness = new uint8_t[numLEDs]; // Per-LED brightness (0-255)
-    memset(this->ledData, 0, numLEDs * colorComponentCount);
-    memset(this->ledBrightness, 255, numLEDs); // Default brightness is 255
+    initialize(buffers);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Constructor for a color order that is known at compile time.
+///
+ShiftLED::ShiftLED(const ColorComponent* order, uint8_t componentCount, uint32_t numLEDs, uint8_t dataPin,
+                   SPIClass& SPI_peripheral, const ShiftLEDBuffers* buffers)
+    : ShiftLED(numLEDs, dataPin, SPI_peripheral) {
+    colorComponentCount = componentCount;
+    memcpy(colorOrder, order, componentCount * sizeof(ColorComponent));
+
+    initialize(buffers);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets every member to its default; all other constructors delegate here.
+///
+ShiftLED::ShiftLED(uint32_t numLEDs, uint8_t dataPin, SPIClass& SPI_peripheral)
+    : numLEDs(numLEDs), capacity(numLEDs), callerBuffers(), begun(false), brightnessRefused(false),
+      dataPin(dataPin), desiredGlobalBrightness(255), actualGlobalBrightness(255), SPI_peripheral(SPI_peripheral),
+      encoding(SPI_ENCODING_8BIT), wireBuffers{nullptr, nullptr}, frontBuffer(0),
+      wireBufferSize(0), chunkLEDs(0), backend(nullptr), frameCompleteCallback(nullptr), transferActive(false),
+      lastFrameEnd_us(0), wireBytesPerLED(0), dirtyTracking(true), fullRefreshPending(true), dirtyEnd(0),
+      sentGlobalBrightness(255), bytesSaved(0), storage(PIXEL_STORAGE_DIRECT), palette(nullptr),
+      paletteWeights(nullptr), paletteSize(0), paletteUsed(0), gamma(1.0f), gammaCurve(nullptr),
+      colorCorrection(255, 255, 255, 255, 255, 255), dithering(false), ditherFrame(0), ditherOffset(128),
+      colorTables(nullptr), colorTableCount(0), colorTablesStale(true), tableGlobalBrightness(0),
+      colorComponentCount(0), powerWeightSum(0), powerWeightSumStale(false), maxAllowedPower_mW(0),
+      maxPowerPerLED_mW(300), // Default maxPowerPerLED_mW is 300
+      powerZones(nullptr), powerZoneCount(0), supplyVoltage_mV(5000) {
+    setTimingProfile(chipTypes[0].timing);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Counts the active components and allocates (or takes the caller's) LED and wire buffers.
+///
+void ShiftLED::initialize(const ShiftLEDBuffers* buffers) {
+    activeComponentCount = 0;
+    for (uint8_t i = 0; i < colorComponentCount; ++i) {
+        if (colorOrder[i] != NONE) activeComponentCount++;
+    }
+
+    this->ledData = nullptr;
+    this->ledBrightness = nullptr;
+    this->pipelineEnabled = false;
+    memset(this->pipelineFrames, 0, sizeof(this->pipelineFrames));
+    this->frameData = nullptr;
+    this->frameBrightness = nullptr;
+    if (buffers != nullptr) {
+        // The caller's buffers set the capacity; the strip never frees them
+        this->callerBuffers = *buffers;
+        this->capacity = buffers->capacity;
+        if (this->numLEDs > this->capacity) {
+            Serial.println("Not enough capacity.");
+            this->numLEDs = this->capacity;
+        }
+    }
+    allocatePixels();
+    allocateWireBuffer();
+    resetStats();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the bytes of pixel storage for count LEDs.
+///
+size_t ShiftLED::getStorageSize(uint32_t count) const {
+    switch (storage) {
+        case PIXEL_STORAGE_PALETTE8: return count;
+        case PIXEL_STORAGE_PALETTE4: return ((size_t)count + 1) / 2;
+        case PIXEL_STORAGE_DIRECT:
+        default:                     return (size_t)count * colorComponentCount;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief (Re)allocates the pixel storage for the capacity, keeping the first keepLEDs LEDs and clearing the rest.
+///
+void ShiftLED::allocatePixels(uint32_t keepLEDs) {
+    // Byte offsets into the pixel and wire buffers are computed in 32 bits
+    if (capacity > MAX_LEDS) {
+        Serial.println("Too many LEDs.");
+        capacity = MAX_LEDS;
+    }
+    if (numLEDs > capacity) numLEDs = capacity;
+    if (keepLEDs > numLEDs) keepLEDs = numLEDs;
+
+    size_t size = getStorageSize(capacity);
+    size_t kept = getStorageSize(keepLEDs);
+    if (pipelineEnabled) {
+        // Every frame starts out black with all LEDs at full brightness; the render frame keeps the pixels
+        PipelineFrame frames[3];
+        for (uint8_t f = 0; f < 3; f++) {
+            frames[f].data = new uint8_t[size];
+            frames[f].brightness = new uint8_t[capacity];
+            memset(frames[f].data, 0, size);
+            memset(frames[f].brightness, 255, capacity);
+            frames[f].powerWeightSum = 0;
+        }
+        if (kept != 0) {
+            memcpy(frames[0].data, this->ledData, kept);
+            if (this->ledBrightness != nullptr) memcpy(frames[0].brightness, this->ledBrightness, keepLEDs);
+        }
+        releasePixels();
+        memcpy(pipelineFrames, frames, sizeof(frames));
+        renderFrame = 0;
+        pipelineState = 1;
+        outputFrame = 2;
+        this->ledData = pipelineFrames[renderFrame].data;
+        this->ledBrightness = pipelineFrames[renderFrame].brightness;
+    } else if (callerBuffers.pixels != nullptr) {
+        // The caller's buffer is used in place and already holds the kept pixels
+        this->ledData = callerBuffers.pixels;
+        memset(this->ledData + kept, 0, size - kept);
+        if (kept == 0) this->ledBrightness = nullptr;
+    } else {
+        uint8_t* data = new uint8_t[size];
+        uint8_t* brightness = nullptr; // Allocated once a brightness other than 255 is used
+        if (kept != 0) {
+            memcpy(data, this->ledData, kept);
+            if (this->ledBrightness != nullptr) {
+                brightness = new uint8_t[capacity];
+                memcpy(brightness, this->ledBrightness, keepLEDs);
+                memset(brightness + keepLEDs, 255, capacity - keepLEDs);
+            }
+        }
+        memset(data + kept, 0, size - kept); // All LEDs off (palette entry 0 is black)
+        releasePixels();
+        this->ledData = data;
+        this->ledBrightness = brightness;
+    }
+
+    powerWeightSum = 0;
+    powerWeightSumStale = (keepLEDs != 0);
+    fullRefreshPending = true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Frees the pixel storage, including the pipeline frames.
+///
+void ShiftLED::releasePixels() {
+    if (pipelineFrames[0].data != nullptr) {
+        // ledData and ledBrightness point into the frames
+        for (uint8_t f = 0; f < 3; f++) {
+            delete[] pipelineFrames[f].data;
+            delete[] pipelineFrames[f].brightness;
+            pipelineFrames[f].data = nullptr;
+            pipelineFrames[f].brightness = nullptr;
+        }
+    } else {
+        // Caller-provided buffers are not ours to free
+        if (this->ledData != callerBuffers.pixels) delete[] this->ledData;
+        if (this->ledBrightness != callerBuffers.brightness) delete[] this->ledBrightness;
+    }
+    this->ledData = nullptr;
+    this->ledBrightness = nullptr;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Allocates (or takes the caller's) per-LED brightness array with every LED at 255.
+///
+void ShiftLED::allocateBrightness() {
+    // A strip on caller-provided pixels without a brightness buffer ignores per-LED brightness, and so does
+    // a heap strip whose array was not allocated before begin()
+    if (begun && callerBuffers.pixels == nullptr) {
+        if (!brightnessRefused) Serial.println("Per-LED brightness needs reserveBrightness() before begin().");
+        brightnessRefused = true;
+        return;
+    }
+    if (callerBuffers.brightness != nullptr) {
+        this->ledBrightness = callerBuffers.brightness;
+    } else if (callerBuffers.pixels == nullptr) {
+        this->ledBrightness = new uint8_t[capacity];
+    }
+    if (this->ledBrightness != nullptr) {
+        memset(this->ledBrightness, 255, capacity);
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Allocates the per-LED brightness array up front. Call before begin().
+///
+bool ShiftLED::reserveBrightness() {
+    if (ledBrightness == nullptr) allocateBrightness();
+    return ledBrightness != nullptr;
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
 /// @brief Destructor for ShiftLED class.
 ///
 ShiftLED::~ShiftLED() {
-    delete[] this->ledData;
-    delete[] this->ledBrightness;
     end();
+    releasePixels();
+    if (this->wireBuffers[0] != callerBuffers.wire) {
+        delete[] this->wireBuffers[0];
+        delete[] this->wireBuffers[1];
+    }
+    delete[] this->colorTables;
+    delete[] this->gammaCurve;
+    delete[] this->palette;
+    delete[] this->paletteWeights;
+    delete[] this->powerZones;
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
@@ -35,150 +286,1242 @@ ShiftLED::~ShiftLED() {
 ///
 bool ShiftLED::parseLEDType(String ledTypeString) {
     ledTypeString.toUpperCase();
-    this->ledType = ledTypeString;
 
-    colorOrder.clear();
+    colorComponentCount = 0;
 
-    if (ledTypeString == "WS2812" || ledTypeString == "NEOPIXEL" || ledTypeString == "SK6812") {
-        colorOrder = {GREEN, RED, BLUE}; // WS2812 and SK6812 use GRB order
-        return true;
-    } else {
-        // Parse color order strings like "RGB", "GRBW", "RGBCHN"
-        for (char &c : ledTypeString) {
-            switch (c) {
-                case 'R': colorOrder.push_back(RED); break;
-                case 'G': colorOrder.push_back(GREEN); break;
-                case 'B': colorOrder.push_back(BLUE); break;
-                case 'W': colorOrder.push_back(WHITE); break;
-                case 'C': colorOrder.push_back(COLD_WHITE); break;
-                case 'H': colorOrder.push_back(WARM_WHITE); break;
-                case 'N': colorOrder.push_back(NONE); break;
-                default:
-                    Serial.print("Unsupported color component: ");
-                    Serial.println(c);
-                    return false;
-            }
-        }
+    // Chip names select the chip's timing and color order
+    const char* chipOrder;
+    SPIEncoding chipEncoding;
+    const LEDTimingProfile* chip = findChip(ledTypeString, &chipOrder, &chipEncoding);
+    if (chip != nullptr) {
+        setTimingProfile(*chip);
+        encoding = chipEncoding; // The wire buffers are allocated after parsing
+        ledTypeString = chipOrder;
+    }
 
-        if (colorOrder.empty()) {
-            Serial.println("Invalid LED type or color order.");
+    // Parse color order strings like "RGB", "GRBW", "RGBCHN"
+    for (char &c : ledTypeString) {
+        if (colorComponentCount >= MAX_COLOR_COMPONENTS) {
+            Serial.println("Too many color components.");
+            colorComponentCount = 0;
             return false;
         }
 
-        return true;
+        switch (c) {
+            case 'R': colorOrder[colorComponentCount++] = RED; break;
+            case 'G': colorOrder[colorComponentCount++] = GREEN; break;
+            case 'B': colorOrder[colorComponentCount++] = BLUE; break;
+            case 'W': colorOrder[colorComponentCount++] = WHITE; break;
+            case 'C': colorOrder[colorComponentCount++] = COLD_WHITE; break;
+            case 'H': colorOrder[colorComponentCount++] = WARM_WHITE; break;
+            case 'N': colorOrder[colorComponentCount++] = NONE; break;
+            default:
+                Serial.print("Unsupported color component: ");
+                Serial.println(c);
+                return false;
+        }
+    }
+
+    if (colorComponentCount == 0) {
+        Serial.println("Invalid LED type or color order.");
+        return false;
+    }
+
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Looks up the timing, color order and encoding of a known chip; returns nullptr for unknown names.
+///
+const LEDTimingProfile* ShiftLED::findChip(const String& chipName, const char** colorOrderString,
+                                           SPIEncoding* chipEncoding) {
+    for (const ChipType& chip : chipTypes) {
+        if (strcasecmp(chipName.c_str(), chip.timing.name) == 0) {
+            if (colorOrderString != nullptr) *colorOrderString = chip.colorOrder;
+            if (chipEncoding != nullptr) *chipEncoding = chip.encoding;
+            return &chip.timing;
+        }
     }
+    return nullptr;
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
 /// @brief Initializes the ShiftLED object and begins SPI communication.
 ///
 void ShiftLED::begin() {
+    if (chunkLEDs != 0 && !canStream()) {
+        // Blocking chunks would leave the line idle while each one is encoded
+        Serial.println("Streaming single-wire chips needs an asynchronous backend; sending whole frames.");
+        chunkLEDs = 0;
+        allocateWireBuffer();
+    }
+
+    // The color tables are built now, so the first frame does not allocate
+    buildColorTables();
+    begun = true;
+
+    if (backend != nullptr) {
+        backend->begin(getEncodingClock(), wireBufferSize, getSPIMode());
+        lastFrameEnd_us = micros();
+        return;
+    }
+
     pinMode(this->dataPin, OUTPUT);
     SPI_peripheral.begin();
     // Start SPI transaction here
-    SPI_peripheral.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE1));
+    uint8_t mode = getSPIMode() == 0 ? SPI_MODE0 : SPI_MODE1;
+    SPI_peripheral.beginTransaction(SPISettings(getEncodingClock(), MSBFIRST, mode));
+
+    // Pull the data line low; the first frame waits for the reset time from here
+    SPI_peripheral.transfer(0x00);
+    lastFrameEnd_us = micros();
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
 /// @brief Ends SPI communication and cleans up resources.
 ///
 void ShiftLED::end() {
+    begun = false;
+    if (backend != nullptr) {
+        waitForTransfer();
+        backend->end();
+        return;
+    }
+
     // End SPI transaction here
     SPI_peripheral.endTransaction();
     SPI_peripheral.end();
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Sets the color of a single LED using color components.
+/// @brief Selects the SPI encoding used on the wire. Call before begin().
+///
+bool ShiftLED::setEncoding(SPIEncoding encoding) {
+    if (this->encoding == encoding) return true;
+    if (begun) {
+        Serial.println("Call setEncoding() before begin().");
+        return false;
+    }
+    waitForTransfer();
+    this->encoding = encoding;
+    allocateWireBuffer();
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the SPI encoding used on the wire.
+///
+SPIEncoding ShiftLED::getEncoding() const {
+    return this->encoding;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Selects the timing of a known chip, keeping the color order. Call before begin().
+///
+bool ShiftLED::setTimingProfile(String chipName) {
+    SPIEncoding chipEncoding;
+    const LEDTimingProfile* chip = findChip(chipName, nullptr, &chipEncoding);
+    if (chip == nullptr) {
+        Serial.print("Unknown LED chip: ");
+        Serial.println(chipName);
+        return false;
+    }
+
+    // Switching between the single-wire and the clocked protocol changes the encoding;
+    // a denser single-wire encoding is kept
+    if ((chipEncoding == SPI_ENCODING_APA102 || encoding == SPI_ENCODING_APA102) && !setEncoding(chipEncoding)) {
+        return false;
+    }
+    return setTimingProfile(*chip);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Selects a custom chip timing. Call before begin().
+///
+bool ShiftLED::setTimingProfile(const LEDTimingProfile& profile) {
+    // A '1' must stay high at least as long as a '0', and both must start high; clocked chips have no patterns
+    bool clocked = profile.onePattern == 0 && profile.zeroPattern == 0;
+    if (profile.clock_Hz == 0 || (!clocked && ((profile.zeroPattern & ~profile.onePattern) != 0 ||
+        (profile.zeroPattern & 0x80) == 0 || profile.onePattern == profile.zeroPattern))) {
+        Serial.println("Invalid LED timing profile.");
+        return false;
+    }
+
+    waitForTransfer();
+    timing = profile;
+    for (uint8_t nibble = 0; nibble < 16; nibble++) {
+        for (uint8_t bit = 0; bit < 4; bit++) {
+            encodeTable8Bit[nibble][bit] = (nibble & (8 >> bit)) ? profile.onePattern : profile.zeroPattern;
+        }
+    }
+    fullRefreshPending = true;
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the chip timing in use.
+///
+const LEDTimingProfile& ShiftLED::getTimingProfile() const {
+    return timing;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sends frames through a (DMA) backend instead of blocking SPI transfers. Call before begin().
+///
+bool ShiftLED::setBackend(ShiftLEDBackend* backend) {
+    if (this->backend == backend) return true;
+    if (begun) {
+        Serial.println("Call setBackend() before begin().");
+        return false;
+    }
+    waitForTransfer();
+    this->backend = backend;
+    // A second wire buffer lets the next frame be encoded while the current one is on the bus
+    allocateWireBuffer();
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the callback invoked when an asynchronous frame has finished sending.
+///
+void ShiftLED::setFrameCompleteCallback(FrameCompleteCallback callback) {
+    this->frameCompleteCallback = callback;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Encodes frames in chunks of this many LEDs just ahead of the transfer (0 = whole frame). Call before
+/// begin().
+///
+bool ShiftLED::setWireChunkSize(uint16_t ledsPerChunk) {
+    if (this->chunkLEDs == ledsPerChunk) return true;
+    if (begun) {
+        Serial.println("Call setWireChunkSize() before begin().");
+        return false;
+    }
+    waitForTransfer();
+    this->chunkLEDs = ledsPerChunk;
+    allocateWireBuffer();
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks whether frames can be sent in chunks without the strip latching between two of them.
+///
+bool ShiftLED::canStream() const {
+    // Clocked chips wait for the next clock edge. Single-wire chips latch once the line idles for the reset
+    // time, and a blocking transfer leaves it idle while the next chunk is encoded; an asynchronous backend
+    // sends the current chunk while the next one is encoded.
+    return encoding == SPI_ENCODING_APA102 || (backend != nullptr && backend->isAsynchronous());
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the SPI clock frequency in Hz for the selected encoding.
+///
+uint32_t ShiftLED::getEncodingClock() const {
+    // All encodings keep the LED bit period of the chip (1.0 µs at 8 MHz)
+    switch (encoding) {
+        case SPI_ENCODING_4BIT: return timing.clock_Hz / 2;
+        case SPI_ENCODING_3BIT: return timing.clock_Hz / 8 * 3;
+        case SPI_ENCODING_APA102:
+        case SPI_ENCODING_8BIT:
+        default:                return timing.clock_Hz;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the SPI mode (0-3) for the selected encoding.
+///
+uint8_t ShiftLED::getSPIMode() const {
+    // Clocked chips sample on the rising edge; the single-wire protocol only uses the data line
+    return encoding == SPI_ENCODING_APA102 ? 0 : 1;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the number of bytes on the wire for a frame of count LEDs.
+///
+size_t ShiftLED::getFrameLength(uint32_t count) const {
+    if (encoding != SPI_ENCODING_APA102) {
+        return (size_t)count * wireBytesPerLED;
+    }
+
+    // 32-bit start frame, then a 32-bit reset frame (SK9822) and half a clock edge per LED to push
+    // the data through the strip
+    return 4 + (size_t)count * wireBytesPerLED + 4 + ((size_t)count + 15) / 16;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief (Re)allocates the wire buffer for the current LED count and encoding.
+///
+void ShiftLED::allocateWireBuffer() {
+    size_t bytesPerColor;
+    switch (encoding) {
+        case SPI_ENCODING_4BIT:   bytesPerColor = 4; break;
+        case SPI_ENCODING_3BIT:   bytesPerColor = 3; break;
+        case SPI_ENCODING_APA102: bytesPerColor = 1; break;
+        case SPI_ENCODING_8BIT:
+        default:                  bytesPerColor = 8; break;
+    }
+
+    if (this->wireBuffers[0] != callerBuffers.wire) {
+        delete[] this->wireBuffers[0];
+        delete[] this->wireBuffers[1];
+    }
+    this->wireBytesPerLED = colorComponentCount * bytesPerColor;
+    if (encoding == SPI_ENCODING_APA102) {
+        this->wireBytesPerLED++; // Header byte with the hardware brightness
+    }
+    this->wireBufferSize = getFrameLength(capacity);
+    if (chunkLEDs != 0) {
+        // Streamed frames only need room for one chunk (or the APA102 start frame)
+        uint32_t leds = (chunkLEDs < capacity) ? chunkLEDs : capacity;
+        this->wireBufferSize = (size_t)leds * wireBytesPerLED;
+        if (this->wireBufferSize < 4) this->wireBufferSize = 4;
+    }
+    this->frontBuffer = 0;
+
+    if (callerBuffers.wire == nullptr) {
+        this->wireBuffers[0] = new uint8_t[wireBufferSize];
+        this->wireBuffers[1] = (backend != nullptr) ? new uint8_t[wireBufferSize] : nullptr;
+        return;
+    }
+
+    // The caller's buffer is split in two halves with a backend
+    size_t available = (backend != nullptr) ? callerBuffers.wireSize / 2 : callerBuffers.wireSize;
+    if (this->wireBufferSize > available) {
+        // Shrink what the buffer has to hold: the chunk when streaming, otherwise the strip
+        Serial.println("Wire buffer too small.");
+        uint32_t fits = available / wireBytesPerLED;
+        while (fits > 0 && getFrameLength(fits) > available) fits--;
+        if (chunkLEDs != 0 && fits > 0) {
+            chunkLEDs = fits;
+        } else {
+            capacity = fits;
+            if (numLEDs > capacity) numLEDs = capacity;
+        }
+    }
+    this->wireBufferSize = available;
+    this->wireBuffers[0] = callerBuffers.wire;
+    this->wireBuffers[1] = (backend != nullptr) ? callerBuffers.wire + available : nullptr;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Blocks until the frame in flight has been sent.
+///
+void ShiftLED::waitForTransfer() {
+    while (isBusy()) {}
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Waits for the part of the reset time that has not passed since the last frame.
+///
+void ShiftLED::waitForReset() {
+    // The line has been low since lastFrameEnd_us; time spent encoding or in loop() counts towards the reset
+    uint32_t idle_us = micros() - lastFrameEnd_us;
+    if (idle_us < timing.reset_us) {
+        delayMicroseconds(timing.reset_us - idle_us);
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of a single LED using color components.
+///
+void ShiftLED::setLEDColor(uint32_t index, uint8_t red, uint8_t green, uint8_t blue,
+                           uint8_t white, uint8_t warmWhite, uint8_t coldWhite,
+                           uint8_t brightness) {
+    if (index >= this->numLEDs) return;
+
+    // Remove the old contribution from the running power sum
+    powerWeightSum -= getPowerWeight(index);
+
+    if (storage == PIXEL_STORAGE_DIRECT) {
+        storeComponents(&this->ledData[index * colorComponentCount], red, green, blue, white, warmWhite, coldWhite);
+    } else {
+        uint8_t color[MAX_COLOR_COMPONENTS];
+        storeComponents(color, red, green, blue, white, warmWhite, coldWhite);
+        storePaletteIndex(index, findPaletteEntry(color));
+    }
+
+    // Store per-LED brightness
+    storeBrightness(index, 1, brightness);
+    markDirty(index);
+
+    powerWeightSum += getPowerWeight(index);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Stores color components in the strip's color order.
+///
+void ShiftLED::storeComponents(uint8_t* p, uint8_t red, uint8_t green, uint8_t blue,
+                               uint8_t white, uint8_t warmWhite, uint8_t coldWhite) const {
+    // Store colors in the order specified by colorOrder
+    for (uint8_t i = 0; i < colorComponentCount; ++i) {
+        switch (colorOrder[i]) {
+            case RED:        p[i] = red; break;
+            case GREEN:      p[i] = green; break;
+            case BLUE:       p[i] = blue; break;
+            case WHITE:      p[i] = white; break;
+            case WARM_WHITE: p[i] = warmWhite; break;
+            case COLD_WHITE: p[i] = coldWhite; break;
+            case NONE:       p[i] = 0; break; // Data doesn't matter but should be in proper format
+            default:         p[i] = 0; break;
+        }
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of a single LED using a color value.
+///
+void ShiftLED::setLEDColor(uint32_t index, const LEDColor& color, uint8_t brightness) {
+    setLEDColor(index, color.red, color.green, color.blue, color.white, color.warmWhite, color.coldWhite,
+                brightness);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of a single LED using a color string.
+///
+void ShiftLED::setLEDColor(uint32_t index, const char* colorString, uint8_t brightness) {
+    LEDColor color;
+    if (!parseLEDColor(colorString, strlen(colorString), color)) {
+        Serial.print("Failed to parse color string: ");
+        Serial.println(colorString);
+        return;
+    }
+    setLEDColor(index, color, brightness);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of a single LED using a color string.
+///
+void ShiftLED::setLEDColor(uint32_t index, const String& colorString, uint8_t brightness) {
+    setLEDColor(index, colorString.c_str(), brightness);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of all LEDs using color components.
+///
+void ShiftLED::setAllLEDs(uint8_t red, uint8_t green, uint8_t blue,
+                          uint8_t white, uint8_t warmWhite, uint8_t coldWhite,
+                          uint8_t brightness) {
+    if (this->numLEDs == 0) return;
+
+    // Store the first LED, then replicate it
+    setLEDColor(0, red, green, blue, white, warmWhite, coldWhite, brightness);
+
+    replicatePixel(0, numLEDs);
+    storeBrightness(0, numLEDs, brightness);
+    dirtyEnd = numLEDs;
+
+    powerWeightSum = (uint64_t)getPowerWeight(0) * numLEDs;
+    powerWeightSumStale = false;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of all LEDs using a color value.
+///
+void ShiftLED::setAllLEDs(const LEDColor& color, uint8_t brightness) {
+    setAllLEDs(color.red, color.green, color.blue, color.white, color.warmWhite, color.coldWhite, brightness);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of all LEDs using a color string.
+///
+void ShiftLED::setAllLEDs(const char* colorString, uint8_t brightness) {
+    LEDColor color;
+    if (!parseLEDColor(colorString, strlen(colorString), color)) {
+        Serial.print("Failed to parse color string: ");
+        Serial.println(colorString);
+        return;
+    }
+    setAllLEDs(color, brightness);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of all LEDs using a color string.
+///
+void ShiftLED::setAllLEDs(const String& colorString, uint8_t brightness) {
+    setAllLEDs(colorString.c_str(), brightness);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of count LEDs starting at start.
+///
+void ShiftLED::fillRange(uint32_t start, uint32_t count, const LEDColor& color, uint8_t brightness) {
+    if (start >= this->numLEDs || count == 0) return;
+    if (count > this->numLEDs - start) count = this->numLEDs - start;
+
+    // setLEDColor() accounts for the first LED
+    powerWeightSum -= sumPowerWeights(start + 1, count - 1);
+
+    // Store the first LED, then replicate it
+    setLEDColor(start, color, brightness);
+
+    replicatePixel(start, count);
+    storeBrightness(start, count, brightness);
+    markDirty(start + count - 1);
+
+    powerWeightSum += (uint64_t)getPowerWeight(start) * (count - 1);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Copies the color of the LED at start to the following count - 1 LEDs.
+///
+void ShiftLED::replicatePixel(uint32_t start, uint32_t count) {
+    switch (storage) {
+        case PIXEL_STORAGE_DIRECT: {
+            uint8_t* first = &this->ledData[start * colorComponentCount];
+            for (uint32_t i = 1; i < count; i++) {
+                memcpy(first + i * colorComponentCount, first, colorComponentCount);
+            }
+            break;
+        }
+        case PIXEL_STORAGE_PALETTE8:
+            memset(&this->ledData[start], this->ledData[start], count);
+            break;
+        case PIXEL_STORAGE_PALETTE4: {
+            uint8_t entry = getPaletteIndex(start);
+            uint32_t end = start + count;
+            uint32_t i = start + 1;
+            // Odd LED up to the next byte boundary, whole bytes, then the trailing even LED
+            if (i < end && (i & 1)) storePaletteIndex(i++, entry);
+            uint32_t pairs = (end - i) / 2;
+            memset(&this->ledData[i >> 1], entry | (entry << 4), pairs);
+            i += pairs * 2;
+            if (i < end) storePaletteIndex(i, entry);
+            break;
+        }
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Copies count packed pixels into the strip starting at start, remapping them to the color order.
+///
+void ShiftLED::setPixels(uint32_t start, const uint8_t* pixels, uint32_t count, PixelFormat format,
+                         uint8_t brightness) {
+    if (start >= this->numLEDs || count == 0) return;
+    if (count > this->numLEDs - start) count = this->numLEDs - start;
+
+    static const ColorComponent rgbOrder[] = {RED, GREEN, BLUE, WHITE};
+    uint8_t sourceStride = (format == PIXEL_FORMAT_RGB) ? 3 : (format == PIXEL_FORMAT_RGBW) ? 4 : colorComponentCount;
+
+    // Same layout as the strip: a plain copy
+    bool sameOrder = (format == PIXEL_FORMAT_NATIVE);
+    if (!sameOrder && sourceStride == colorComponentCount) {
+        sameOrder = memcmp(colorOrder, rgbOrder, sourceStride * sizeof(ColorComponent)) == 0;
+    }
+
+    powerWeightSum -= sumPowerWeights(start, count);
+
+    uint8_t* p = (storage == PIXEL_STORAGE_DIRECT) ? &this->ledData[start * colorComponentCount] : nullptr;
+    if (sameOrder && storage == PIXEL_STORAGE_DIRECT) {
+        memcpy(p, pixels, (size_t)count * colorComponentCount);
+    } else {
+        // Resolve each destination component to a source offset once, or -1 for components the source lacks
+        int8_t sourceOffset[MAX_COLOR_COMPONENTS];
+        for (uint8_t c = 0; c < colorComponentCount; ++c) {
+            sourceOffset[c] = sameOrder ? c : -1;
+            for (uint8_t k = 0; k < sourceStride && !sameOrder; ++k) {
+                if (colorOrder[c] == rgbOrder[k]) sourceOffset[c] = k;
+            }
+        }
+
+        uint8_t color[MAX_COLOR_COMPONENTS];
+        for (uint32_t i = 0; i < count; i++) {
+            // Palette storage converts through a temporary color and maps it to an entry
+            uint8_t* target = (storage == PIXEL_STORAGE_DIRECT) ? p : color;
+            for (uint8_t c = 0; c < colorComponentCount; ++c) {
+                target[c] = (sourceOffset[c] >= 0) ? pixels[sourceOffset[c]] : 0;
+            }
+            if (storage == PIXEL_STORAGE_DIRECT) {
+                p += colorComponentCount;
+            } else {
+                storePaletteIndex(start + i, findPaletteEntry(color));
+            }
+            pixels += sourceStride;
+        }
+    }
+
+    storeBrightness(start, count, brightness);
+    markDirty(start + count - 1);
+
+    powerWeightSum += sumPowerWeights(start, count);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Copies count LEDs (color and brightness) from src to dst. The ranges may overlap.
+///
+void ShiftLED::copyRange(uint32_t dst, uint32_t src, uint32_t count) {
+    if (dst >= this->numLEDs || src >= this->numLEDs || count == 0) return;
+    if (count > this->numLEDs - dst) count = this->numLEDs - dst;
+    if (count > this->numLEDs - src) count = this->numLEDs - src;
+
+    powerWeightSum -= sumPowerWeights(dst, count);
+
+    switch (storage) {
+        case PIXEL_STORAGE_DIRECT:
+            memmove(&this->ledData[dst * colorComponentCount], &this->ledData[src * colorComponentCount],
+                    (size_t)count * colorComponentCount);
+            break;
+        case PIXEL_STORAGE_PALETTE8:
+            memmove(&this->ledData[dst], &this->ledData[src], count);
+            break;
+        case PIXEL_STORAGE_PALETTE4:
+            // Packed indices move one at a time, in the direction that keeps overlapping ranges intact
+            if (dst < src) {
+                for (uint32_t i = 0; i < count; i++) storePaletteIndex(dst + i, getPaletteIndex(src + i));
+            } else {
+                for (uint32_t i = count; i-- > 0;) storePaletteIndex(dst + i, getPaletteIndex(src + i));
+            }
+            break;
+    }
+    if (this->ledBrightness != nullptr) {
+        memmove(&this->ledBrightness[dst], &this->ledBrightness[src], count);
+    }
+    markDirty(dst + count - 1);
+
+    powerWeightSum += sumPowerWeights(dst, count);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Moves all LEDs by offset positions (towards the end if positive) and turns vacated LEDs off.
+///
+void ShiftLED::shift(int32_t offset) {
+    if (offset == 0) return;
+
+    uint32_t distance = (offset > 0) ? offset : -offset;
+    if (distance >= this->numLEDs) {
+        setAllLEDs(0, 0, 0);
+        return;
+    }
+
+    uint32_t remaining = this->numLEDs - distance;
+    if (offset > 0) {
+        copyRange(distance, 0, remaining);
+        fillRange(0, distance, LEDColor());
+    } else {
+        copyRange(0, distance, remaining);
+        fillRange(remaining, distance, LEDColor());
+    }
+}
+
+// Pixel kernels: color bytes are processed four at a time in a 32-bit word (SWAR). Multiplies work on
+// every other byte so each 8x9-bit product has 16 bits of room and cannot carry into its neighbor.
+static const uint32_t EVEN_BYTES = 0x00FF00FFUL;
+static const uint32_t HIGH_BITS = 0x80808080UL;
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Scales length bytes by scale/256 (256 = unchanged).
+///
+static void scaleBytes(uint8_t* p, size_t length, uint16_t scale) {
+    for (; length >= 4; length -= 4, p += 4) {
+        uint32_t word;
+        memcpy(&word, p, 4);
+        uint32_t even = (((word & EVEN_BYTES) * scale) >> 8) & EVEN_BYTES;
+        uint32_t odd = (((word >> 8) & EVEN_BYTES) * scale) & ~EVEN_BYTES;
+        word = even | odd;
+        memcpy(p, &word, 4);
+    }
+    for (size_t i = 0; i < length; i++) {
+        p[i] = (p[i] * scale) >> 8;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Blends length bytes of source into target with weight/256 (256 = source).
+///
+static void blendBytes(uint8_t* target, const uint8_t* source, size_t length, uint16_t weight) {
+    uint16_t inverse = 256 - weight;
+    for (; length >= 4; length -= 4, target += 4, source += 4) {
+        uint32_t a, b;
+        memcpy(&a, target, 4);
+        memcpy(&b, source, 4);
+        uint32_t even = (((a & EVEN_BYTES) * inverse + (b & EVEN_BYTES) * weight) >> 8) & EVEN_BYTES;
+        uint32_t odd = (((a >> 8) & EVEN_BYTES) * inverse + ((b >> 8) & EVEN_BYTES) * weight) & ~EVEN_BYTES;
+        a = even | odd;
+        memcpy(target, &a, 4);
+    }
+    for (size_t i = 0; i < length; i++) {
+        target[i] = (target[i] * inverse + source[i] * weight) >> 8;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Adds length bytes of source to target, saturating at 255.
+///
+static void addBytes(uint8_t* target, const uint8_t* source, size_t length) {
+    for (; length >= 4; length -= 4, target += 4, source += 4) {
+        uint32_t a, b;
+        memcpy(&a, target, 4);
+        memcpy(&b, source, 4);
+#if defined(__ARM_FEATURE_SIMD32)
+        a = __uqadd8(a, b); // Cortex-M4/M7/M33 add four saturated bytes in one instruction
+#else
+        // Add the low 7 bits of each byte, patch in the high bits, then set every byte that carried out to 255
+        uint32_t sum = ((a & ~HIGH_BITS) + (b & ~HIGH_BITS)) ^ ((a ^ b) & HIGH_BITS);
+        uint32_t carry = ((a & b) | ((a | b) & ~sum)) & HIGH_BITS;
+        a = sum | ((carry >> 7) * 0xFF);
+#endif
+        memcpy(target, &a, 4);
+    }
+    for (size_t i = 0; i < length; i++) {
+        uint16_t sum = target[i] + source[i];
+        target[i] = sum > 255 ? 255 : sum;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Dims the color of every LED by amount/256; per-LED brightness is unchanged.
+///
+void ShiftLED::fadeToBlack(uint8_t amount) {
+    if (this->numLEDs == 0 || amount == 0) return;
+
+    uint16_t scale = 256 - amount;
+    if (storage == PIXEL_STORAGE_DIRECT) {
+        scaleBytes(this->ledData, (size_t)numLEDs * colorComponentCount, scale);
+        markDirty(numLEDs - 1);
+    } else {
+        // Every LED fades alike, so fading the palette fades the strip
+        scaleBytes(this->palette, (size_t)paletteUsed * colorComponentCount, scale);
+        for (uint16_t entry = 0; entry < paletteUsed; entry++) {
+            paletteWeights[entry] = getColorSum(&this->palette[entry * colorComponentCount]);
+        }
+        fullRefreshPending = true;
+    }
+    powerWeightSumStale = true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Blends count native-order pixels into the strip starting at start.
+///
+void ShiftLED::blendPixels(uint32_t start, const uint8_t* pixels, uint32_t count, uint8_t alpha) {
+    // Map 255 to 256 so alpha 255 replaces the pixels exactly
+    combinePixels<false>(start, pixels, count, alpha + (alpha >> 7));
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Adds count native-order pixels to the strip starting at start, saturating at 255.
+///
+void ShiftLED::addPixels(uint32_t start, const uint8_t* pixels, uint32_t count) {
+    combinePixels<true>(start, pixels, count, 0);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Combines count stored pixels from start with native-order pixels.
+///
+template <bool Add>
+void ShiftLED::combinePixels(uint32_t start, const uint8_t* pixels, uint32_t count, uint16_t weight) {
+    if (start >= this->numLEDs || count == 0) return;
+    if (count > this->numLEDs - start) count = this->numLEDs - start;
+
+    if (storage == PIXEL_STORAGE_DIRECT) {
+        uint8_t* p = &this->ledData[(size_t)start * colorComponentCount];
+        size_t length = (size_t)count * colorComponentCount;
+        if (Add) {
+            addBytes(p, pixels, length);
+        } else {
+            blendBytes(p, pixels, length, weight);
+        }
+    } else {
+        // Palette storage combines each LED's palette color and maps the result to an entry
+        uint8_t color[MAX_COLOR_COMPONENTS];
+        for (uint32_t i = 0; i < count; i++) {
+            memcpy(color, &this->palette[getPaletteIndex(start + i) * colorComponentCount], colorComponentCount);
+            if (Add) {
+                addBytes(color, pixels, colorComponentCount);
+            } else {
+                blendBytes(color, pixels, colorComponentCount, weight);
+            }
+            storePaletteIndex(start + i, findPaletteEntry(color));
+            pixels += colorComponentCount;
+        }
+    }
+
+    markDirty(start + count - 1);
+    powerWeightSumStale = true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Fills count LEDs starting at start with one turn of the hue circle from startHue.
+///
+void ShiftLED::fillRainbow(uint32_t start, uint32_t count, uint8_t startHue, uint8_t brightness) {
+    if (start >= this->numLEDs || count == 0) return;
+    if (count > this->numLEDs - start) count = this->numLEDs - start;
+
+    // Hue in 8.16 fixed point so long strips still step evenly
+    uint32_t hue = (uint32_t)startHue << 16;
+    uint32_t step = (1UL << 24) / count;
+
+    // Only red, green and blue are written; resolve their positions once
+    int8_t offsets[3] = {-1, -1, -1};
+    for (uint8_t c = 0; c < colorComponentCount; c++) {
+        if (colorOrder[c] <= BLUE) offsets[colorOrder[c]] = c;
+    }
+
+    if (storage == PIXEL_STORAGE_DIRECT && offsets[0] >= 0 && offsets[1] >= 0 && offsets[2] >= 0) {
+        uint8_t* p = &this->ledData[(size_t)start * colorComponentCount];
+        memset(p, 0, (size_t)count * colorComponentCount);
+        for (uint32_t i = 0; i < count; i++) {
+            LEDColor color = hsvToColor(hue >> 16, 255, 255);
+            p[offsets[0]] = color.red;
+            p[offsets[1]] = color.green;
+            p[offsets[2]] = color.blue;
+            p += colorComponentCount;
+            hue += step;
+        }
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            storeColor(start + i, hsvToColor(hue >> 16, 255, 255));
+            hue += step;
+        }
+    }
+
+    storeBrightness(start, count, brightness);
+    markDirty(start + count - 1);
+    powerWeightSumStale = true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Fills count LEDs starting at start with a linear gradient between two colors.
+///
+void ShiftLED::fillGradient(uint32_t start, uint32_t count, const LEDColor& from, const LEDColor& to,
+                            uint8_t brightness) {
+    if (start >= this->numLEDs || count == 0) return;
+    if (count > this->numLEDs - start) count = this->numLEDs - start;
+
+    // Progress 0-65536 reaches both end colors exactly
+    uint32_t span = (count > 1) ? count - 1 : 1;
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t t = ((uint64_t)i << 16) / span; // Past 65535 LEDs the shifted index needs more than 32 bits
+        storeColor(start + i, LEDColor(from.red + (((to.red - from.red) * t) >> 16),
+                                       from.green + (((to.green - from.green) * t) >> 16),
+                                       from.blue + (((to.blue - from.blue) * t) >> 16),
+                                       from.white + (((to.white - from.white) * t) >> 16),
+                                       from.warmWhite + (((to.warmWhite - from.warmWhite) * t) >> 16),
+                                       from.coldWhite + (((to.coldWhite - from.coldWhite) * t) >> 16)));
+    }
+
+    storeBrightness(start, count, brightness);
+    markDirty(start + count - 1);
+    powerWeightSumStale = true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Stores the color of an LED without updating brightness, dirty range or power sum.
+///
+void ShiftLED::storeColor(uint32_t index, const LEDColor& color) {
+    if (storage == PIXEL_STORAGE_DIRECT) {
+        storeComponents(&this->ledData[(size_t)index * colorComponentCount], color.red, color.green, color.blue,
+                        color.white, color.warmWhite, color.coldWhite);
+    } else {
+        uint8_t native[MAX_COLOR_COMPONENTS];
+        storeComponents(native, color.red, color.green, color.blue, color.white, color.warmWhite, color.coldWhite);
+        storePaletteIndex(index, findPaletteEntry(native));
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets direct access to the native-order LED buffers. Call markPixelsChanged() after writing.
+///
+PixelBuffer ShiftLED::getPixelBuffer() {
+    PixelBuffer buffer;
+    buffer.data = this->ledData;
+    buffer.brightness = this->ledBrightness;
+    buffer.length = this->numLEDs;
+    switch (storage) {
+        case PIXEL_STORAGE_PALETTE8: buffer.stride = 1; break;
+        case PIXEL_STORAGE_PALETTE4: buffer.stride = 0; break;
+        case PIXEL_STORAGE_DIRECT:
+        default:                     buffer.stride = colorComponentCount; break;
+    }
+    return buffer;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Reports LEDs written through getPixelBuffer() so they are sent and counted for power.
+///
+void ShiftLED::markPixelsChanged(uint32_t start, uint32_t count) {
+    if (start >= this->numLEDs || count == 0) return;
+    if (count > this->numLEDs - start) count = this->numLEDs - start;
+
+    markDirty(start + count - 1);
+    // The previous values are gone, so the running sum is rebuilt on next use
+    powerWeightSumStale = true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Selects how LED colors are stored and clears the strip.
+///
+bool ShiftLED::setPixelStorage(PixelStorage storage, uint16_t paletteSize) {
+    if (begun) {
+        Serial.println("Call setPixelStorage() before begin().");
+        return false;
+    }
+    if (pipelineEnabled && storage != PIXEL_STORAGE_DIRECT) {
+        Serial.println("Pipeline requires direct pixel storage.");
+        return false;
+    }
+    waitForTransfer();
+
+    uint16_t maxEntries = (storage == PIXEL_STORAGE_PALETTE4) ? 16 : 256;
+    if (storage == PIXEL_STORAGE_DIRECT) {
+        paletteSize = 0;
+    } else if (paletteSize == 0 || paletteSize > maxEntries) {
+        paletteSize = maxEntries;
+    }
+
+    delete[] this->palette;
+    delete[] this->paletteWeights;
+    this->storage = storage;
+    this->paletteSize = paletteSize;
+    this->palette = nullptr;
+    this->paletteWeights = nullptr;
+    if (paletteSize != 0) {
+        this->palette = new uint8_t[paletteSize * colorComponentCount];
+        this->paletteWeights = new uint16_t[paletteSize];
+        memset(this->palette, 0, paletteSize * colorComponentCount);
+        memset(this->paletteWeights, 0, paletteSize * sizeof(uint16_t));
+    }
+    this->paletteUsed = (paletteSize != 0) ? 1 : 0; // Entry 0 is black, like a cleared strip
+
+    allocatePixels();
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets how LED colors are stored.
+///
+PixelStorage ShiftLED::getPixelStorage() const {
+    return this->storage;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of a palette entry.
+///
+void ShiftLED::setPaletteColor(uint8_t entry, const LEDColor& color) {
+    if (entry >= paletteSize) return;
+
+    uint8_t* p = &this->palette[entry * colorComponentCount];
+    storeComponents(p, color.red, color.green, color.blue, color.white, color.warmWhite, color.coldWhite);
+    paletteWeights[entry] = getColorSum(p);
+    if (entry >= paletteUsed) paletteUsed = entry + 1;
+
+    // Any LED may use the entry
+    fullRefreshPending = true;
+    powerWeightSumStale = true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the palette entry of a single LED.
+///
+void ShiftLED::setPaletteIndex(uint32_t index, uint8_t entry, uint8_t brightness) {
+    if (index >= this->numLEDs || entry >= paletteSize) return;
+
+    powerWeightSum -= getPowerWeight(index);
+    storePaletteIndex(index, entry);
+    storeBrightness(index, 1, brightness);
+    markDirty(index);
+    powerWeightSum += getPowerWeight(index);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Finds the palette entry for a color in the strip's color order, adding it while entries are free.
+///
+uint8_t ShiftLED::findPaletteEntry(const uint8_t* color) {
+    uint8_t nearest = 0;
+    uint16_t nearestDistance = 0xFFFF;
+    for (uint16_t entry = 0; entry < paletteUsed; entry++) {
+        const uint8_t* p = &this->palette[entry * colorComponentCount];
+        uint16_t distance = 0;
+        for (uint8_t c = 0; c < colorComponentCount; ++c) {
+            distance += (p[c] > color[c]) ? p[c] - color[c] : color[c] - p[c];
+        }
+        if (distance == 0) return entry;
+        if (distance < nearestDistance) {
+            nearest = entry;
+            nearestDistance = distance;
+        }
+    }
+
+    if (paletteUsed < paletteSize) {
+        memcpy(&this->palette[paletteUsed * colorComponentCount], color, colorComponentCount);
+        paletteWeights[paletteUsed] = getColorSum(color);
+        return paletteUsed++;
+    }
+
+    // The palette is full; use the closest color
+    return nearest;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the number of color components per LED.
+///
+uint8_t ShiftLED::getColorComponentCount() const {
+    return colorComponentCount;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the color component at a position in the color order.
+///
+ColorComponent ShiftLED::getColorComponent(uint8_t position) const {
+    return (position < colorComponentCount) ? colorOrder[position] : NONE;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the desired global brightness level.
+///
+void ShiftLED::setGlobalBrightness(uint8_t brightnessLevel) {
+    desiredGlobalBrightness = brightnessLevel;
+    // Update actual brightness in case max power is set
+    updateActualBrightness();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the maximum allowed power consumption in milliwatts (mW).
+///
+void ShiftLED::setMaxPower(uint32_t maxPower_mW) {
+    maxAllowedPower_mW = maxPower_mW;
+    // Update actual brightness based on new power limit
+    updateActualBrightness();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the maximum power consumption per LED at full brightness.
+///
+void ShiftLED::setMaxPowerPerLED(uint16_t maxPowerPerLED_mW) {
+    this->maxPowerPerLED_mW = maxPowerPerLED_mW;
+    // Update actual brightness in case this affects power consumption
+    updateActualBrightness();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Adds a power zone of count LEDs starting at start, limited to maxPower_mW (0 = only measured).
+///
+bool ShiftLED::addPowerZone(uint32_t start, uint32_t count, uint32_t maxPower_mW) {
+    const LEDChannelCurrent none = {0, 0, 0, 0, 0, 0};
+    return addPowerZone(start, count, maxPower_mW, none);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Adds a power zone whose power is computed from per-channel currents and the supply voltage.
+///
+bool ShiftLED::addPowerZone(uint32_t start, uint32_t count, uint32_t maxPower_mW, const LEDChannelCurrent& current) {
+    if (powerZoneCount >= MAX_POWER_ZONES) {
+        Serial.println("Too many power zones.");
+        return false;
+    }
+    if (count == 0 || (powerZoneCount > 0 &&
+                       start < (uint64_t)powerZones[powerZoneCount - 1].start + powerZones[powerZoneCount - 1].count)) {
+        Serial.println("Power zones must be added in index order without overlapping.");
+        return false;
+    }
+    if (powerZones == nullptr) {
+        if (begun) {
+            Serial.println("Add the first power zone before begin().");
+            return false;
+        }
+        powerZones = new PowerZone[MAX_POWER_ZONES];
+    }
+
+    PowerZone& zone = powerZones[powerZoneCount++];
+    zone.start = start;
+    zone.count = count;
+    zone.maxPower_mW = maxPower_mW;
+    zone.useCurrent = false;
+    for (uint8_t c = 0; c < colorComponentCount; ++c) {
+        switch (colorOrder[c]) {
+            case RED:        zone.current_mA[c] = current.red_mA; break;
+            case GREEN:      zone.current_mA[c] = current.green_mA; break;
+            case BLUE:       zone.current_mA[c] = current.blue_mA; break;
+            case WHITE:      zone.current_mA[c] = current.white_mA; break;
+            case WARM_WHITE: zone.current_mA[c] = current.warmWhite_mA; break;
+            case COLD_WHITE: zone.current_mA[c] = current.coldWhite_mA; break;
+            case NONE:
+            default:         zone.current_mA[c] = 0; break;
+        }
+        if (zone.current_mA[c] != 0) zone.useCurrent = true;
+    }
+    zone.encodeScale = 256;
+    zone.reading.power_mW = 0;
+    zone.reading.desiredPower_mW = 0;
+    zone.reading.scale = 255;
+
+    // Zones are measured whole, so the next frame sends every LED
+    fullRefreshPending = true;
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Removes all power zones.
+///
+void ShiftLED::clearPowerZones() {
+    powerZoneCount = 0;
+    fullRefreshPending = true; // Limited zones go back to full brightness
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the supply voltage used with per-channel currents.
+///
+void ShiftLED::setSupplyVoltage(uint16_t supply_mV) {
+    supplyVoltage_mV = supply_mV;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the number of power zones.
+///
+uint8_t ShiftLED::getPowerZoneCount() const {
+    return powerZoneCount;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the power drawn by a zone in the last frame.
 ///
-void ShiftLED::setLEDColor(uint16_t index, uint8_t red, uint8_t green, uint8_t blue,
-                           uint8_t white, uint8_t warmWhite, uint8_t coldWhite,
-                           uint8_t brightness) {
-    if (index >= this->numLEDs) return;
+PowerZoneReading ShiftLED::getPowerZoneReading(uint8_t zone) const {
+    if (zone >= powerZoneCount) {
+        PowerZoneReading none = {0, 0, 255};
+        return none;
+    }
+    return powerZones[zone].reading;
+}
 
-    size_t colorComponentCount = colorOrder.size();
-    uint8_t* p = &this->ledData[index * colorComponentCount];
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Converts the output level sums of a zone into milliwatts.
+///
+uint32_t ShiftLED::calculateZonePower(const PowerZone& zone, const uint64_t* levelSums) const {
+    // Clocked chips sum level * hardware level (0-31)
+    uint32_t fullLevel = (encoding == SPI_ENCODING_APA102) ? 255UL * 31 : 255;
+    uint64_t power = 0;
 
-    // Store colors in the order specified by colorOrder
-    for (size_t i = 0; i < colorComponentCount; ++i) {
-        switch (colorOrder[i]) {
-            case RED:        p[i] = red; break;
-            case GREEN:      p[i] = green; break;
-            case BLUE:       p[i] = blue; break;
-            case WHITE:      p[i] = white; break;
-            case WARM_WHITE: p[i] = warmWhite; break;
-            case COLD_WHITE: p[i] = coldWhite; break;
-            case NONE:       p[i] = 0; break; // Data doesn't matter but should be in proper format
-            default:         p[i] = 0; break;
+    if (zone.useCurrent) {
+        // Each channel draws its current in proportion to its output level
+        for (uint8_t c = 0; c < colorComponentCount; ++c) {
+            power += levelSums[c] * zone.current_mA[c];
         }
+        return power * supplyVoltage_mV / (fullLevel * 1000);
     }
 
-    // Store per-LED brightness
-    this->ledBrightness[index] = brightness;
+    // Same model as the global limiter: maxPowerPerLED_mW shared evenly by the active components
+    if (activeComponentCount == 0) return 0;
+    for (uint8_t c = 0; c < colorComponentCount; ++c) {
+        if (colorOrder[c] != NONE) power += levelSums[c];
+    }
+    return power * maxPowerPerLED_mW / (fullLevel * activeComponentCount);
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Sets the color of a single LED using a color string.
+/// @brief Sets the gamma exponent of the output curve.
 ///
-void ShiftLED::setLEDColor(uint16_t index, const String& colorString, uint8_t brightness) {
-    uint8_t red = 0, green = 0, blue = 0, white = 0, warmWhite = 0, coldWhite = 0;
-    if (!parseColorString(colorString, red, green, blue, white, warmWhite, coldWhite)) {
-        Serial.print("Failed to parse color string: ");
-        Serial.println(colorString);
-        return;
+bool ShiftLED::setGamma(float gamma) {
+    if (gammaCurve == nullptr && gamma != 1.0f && begun) {
+        Serial.println("Set a gamma other than 1.0 before begin().");
+        return false;
+    }
+    this->gamma = gamma;
+    colorTablesStale = true;
+    if (gammaCurve == nullptr) {
+        if (gamma == 1.0f) return true;
+        gammaCurve = new uint16_t[256];
+    } else if (gamma == 1.0f && !begun) {
+        delete[] gammaCurve;
+        gammaCurve = nullptr;
+        return true;
     }
-    setLEDColor(index, red, green, blue, white, warmWhite, coldWhite, brightness);
-}
 
-///---------------------------------------------------------------------------------------------------------------------
-/// @brief Sets the color of all LEDs using color components.
-///
-void ShiftLED::setAllLEDs(uint8_t red, uint8_t green, uint8_t blue,
-                          uint8_t white, uint8_t warmWhite, uint8_t coldWhite,
-                          uint8_t brightness) {
-    for (uint16_t i = 0; i < this->numLEDs; i++) {
-        setLEDColor(i, red, green, blue, white, warmWhite, coldWhite, brightness);
+    // The curve is computed once here; brightness changes only rescale it in integer math. After begin() it
+    // is kept at 1.0 (a straight line), so a later gamma does not allocate.
+    for (uint16_t i = 0; i < 256; i++) {
+        gammaCurve[i] = (uint16_t)(pow(i / 255.0f, gamma) * 65280.0f + 0.5f);
     }
+    return true;
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Sets the color of all LEDs using a color string.
+/// @brief Sets the per-channel white balance.
 ///
-void ShiftLED::setAllLEDs(const String& colorString, uint8_t brightness) {
-    uint8_t red = 0, green = 0, blue = 0, white = 0, warmWhite = 0, coldWhite = 0;
-    if (!parseColorString(colorString, red, green, blue, white, warmWhite, coldWhite)) {
-        Serial.print("Failed to parse color string: ");
-        Serial.println(colorString);
-        return;
+bool ShiftLED::setColorCorrection(const LEDColor& correction) {
+    LEDColor previous = this->colorCorrection;
+    this->colorCorrection = correction;
+    uint8_t values[MAX_COLOR_COMPONENTS];
+    uint8_t tableCount = lookUpCorrection(values) ? 1 : colorComponentCount;
+    if (begun && tableCount > colorTableCount) {
+        // The tables are allocated in begin(); a balance that needs more of them would allocate
+        Serial.println("Set a white balance that differs between channels before begin().");
+        this->colorCorrection = previous;
+        return false;
     }
-    setAllLEDs(red, green, blue, white, warmWhite, coldWhite, brightness);
+    colorTablesStale = true;
+    return true;
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Sets the desired global brightness level.
+/// @brief Enables temporal dithering to recover resolution at low brightness.
 ///
-void ShiftLED::setGlobalBrightness(uint8_t brightnessLevel) {
-    desiredGlobalBrightness = brightnessLevel;
-    // Update actual brightness in case max power is set
-    updateActualBrightness();
+void ShiftLED::setDithering(bool enabled) {
+    this->dithering = enabled;
+    ditherOffset = 128; // Round to nearest until the next dithered frame
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Sets the maximum allowed power consumption in milliwatts (mW).
+/// @brief Looks up the white balance of each component; returns true if all components share one value, which
+/// is then stored in correction[0].
 ///
-void ShiftLED::setMaxPower(uint32_t maxPower_mW) {
-    maxAllowedPower_mW = maxPower_mW;
-    // Update actual brightness based on new power limit
-    updateActualBrightness();
+bool ShiftLED::lookUpCorrection(uint8_t* correction) const {
+    // 'NONE' components always send 0 and fit any table
+    int16_t sharedCorrection = -1;
+    bool shared = true;
+    for (uint8_t c = 0; c < colorComponentCount; ++c) {
+        switch (colorOrder[c]) {
+            case RED:        correction[c] = colorCorrection.red; break;
+            case GREEN:      correction[c] = colorCorrection.green; break;
+            case BLUE:       correction[c] = colorCorrection.blue; break;
+            case WHITE:      correction[c] = colorCorrection.white; break;
+            case WARM_WHITE: correction[c] = colorCorrection.warmWhite; break;
+            case COLD_WHITE: correction[c] = colorCorrection.coldWhite; break;
+            case NONE:
+            default:         correction[c] = 255; continue;
+        }
+        if (sharedCorrection < 0) {
+            sharedCorrection = correction[c];
+        } else if (correction[c] != sharedCorrection) {
+            shared = false;
+        }
+    }
+    if (shared && sharedCorrection >= 0) {
+        correction[0] = sharedCorrection;
+    }
+    return shared;
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Sets the maximum power consumption per LED at full brightness.
+/// @brief Rebuilds the color tables for the actual global brightness.
 ///
-void ShiftLED::setMaxPowerPerLED(uint16_t maxPowerPerLED_mW) {
-    this->maxPowerPerLED_mW = maxPowerPerLED_mW;
-    // Update actual brightness in case this affects power consumption
-    updateActualBrightness();
+void ShiftLED::buildColorTables() {
+    // Components share one table unless their white balance differs
+    uint8_t correction[MAX_COLOR_COMPONENTS];
+    bool shared = lookUpCorrection(correction);
+    uint8_t tableCount = shared ? 1 : colorComponentCount;
+    if (tableCount > colorTableCount) {
+        delete[] colorTables;
+        colorTables = new uint16_t[tableCount * 256];
+        colorTableCount = tableCount;
+    }
+
+    for (uint8_t t = 0; t < tableCount; t++) {
+        uint16_t* table = &colorTables[t * 256];
+        uint32_t scale = (uint32_t)actualGlobalBrightness * correction[t]; // 255 * 255 = full scale
+
+        // Entries are 8.8 fixed point; the fraction is kept for rounding and dithering
+        for (uint16_t i = 0; i < 256; i++) {
+            uint32_t level = (gammaCurve != nullptr) ? gammaCurve[i] : (uint32_t)i << 8;
+            table[i] = (level * scale + 32512) / 65025;
+        }
+    }
+
+    for (uint8_t c = 0; c < colorComponentCount; ++c) {
+        componentTables[c] = &colorTables[shared ? 0 : c * 256];
+    }
+
+    colorTablesStale = false;
+    tableGlobalBrightness = actualGlobalBrightness;
+    fullRefreshPending = true;
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
@@ -191,8 +1534,11 @@ void ShiftLED::updateActualBrightness() {
         return;
     }
 
-    // Estimate the current power consumption at desired brightness
-    uint32_t estimatedPower = calculatePowerConsumption(desiredGlobalBrightness);
+    // Estimate the current power consumption at desired brightness; in pipeline mode that of the frame being sent
+    uint32_t estimatedPower = pipelineEnabled
+                                  ? scalePowerWeightSum(pipelineFrames[outputFrame].powerWeightSum,
+                                                        desiredGlobalBrightness)
+                                  : calculatePowerConsumption(desiredGlobalBrightness);
 
     if (estimatedPower > maxAllowedPower_mW) {
         // Reduce actual global brightness proportionally
@@ -205,24 +1551,90 @@ void ShiftLED::updateActualBrightness() {
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Changes the number of LEDs at runtime.
+/// @brief Changes the number of LEDs at runtime; within the capacity the pixels are kept and nothing is allocated.
 ///
-void ShiftLED::setNumLEDs(uint16_t newNumLEDs) {
-    delete[] this->ledData;
-    delete[] this->ledBrightness;
+bool ShiftLED::setNumLEDs(uint32_t newNumLEDs) {
+    if (newNumLEDs > capacity && !reserve(newNumLEDs)) {
+        return false;
+    }
+    waitForTransfer();
+
+    // LEDs the strip grows over are turned off; they may still hold colors from before it shrank
+    uint32_t oldNumLEDs = this->numLEDs;
     this->numLEDs = newNumLEDs;
+    if (newNumLEDs > oldNumLEDs) {
+        clearPixels(oldNumLEDs, newNumLEDs - oldNumLEDs);
+    }
+    if (dirtyEnd > newNumLEDs) dirtyEnd = newNumLEDs;
+    powerWeightSumStale = true;
+    fullRefreshPending = true;
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Turns off count LEDs from start, e.g. after the strip has grown over them.
+///
+void ShiftLED::clearPixels(uint32_t start, uint32_t count) {
+    if (ledBrightness != nullptr) {
+        memset(ledBrightness + start, 255, count);
+    }
+
+    uint32_t end = start + count;
+    if (storage == PIXEL_STORAGE_PALETTE4 && (start & 1)) {
+        ledData[start >> 1] &= 0xF0; // Odd LEDs are the low nibble
+        start++;
+    }
+    size_t first = getStorageSize(start);
+    memset(ledData + first, 0, getStorageSize(end) - first); // Palette entry 0 is black
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Makes room for up to capacity LEDs, keeping the pixels. Call before begin().
+///
+bool ShiftLED::reserve(uint32_t capacity) {
+    if (capacity <= this->capacity) return true;
+    if (begun || callerBuffers.pixels != nullptr || callerBuffers.wire != nullptr) {
+        Serial.println("Not enough capacity; reserve() the LEDs before begin().");
+        return false;
+    }
+    waitForTransfer();
+
+    this->capacity = capacity;
+    allocatePixels(numLEDs);
+    allocateWireBuffer();
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the most LEDs the strip holds without allocating.
+///
+uint32_t ShiftLED::getCapacity() const {
+    return this->capacity;
+}
 
-    size_t colorComponentCount = colorOrder.size();
-    this->ledData = new uint8_t[numLEDs * colorComponentCount];
-    this->ledBrightness = new uint8_t[numLEDs]; // Per-LED brightness (0-255)
-    memset(this->ledData, 0, numLEDs * colorComponentCount);
-    memset(this->ledBrightness, 255, numLEDs); // Default brightness is 255
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the bytes used by the strip, including its heap or caller-provided buffers.
+///
+size_t ShiftLED::getMemoryFootprint() const {
+    size_t bytes = sizeof(*this);
+    size_t pixelBytes = getStorageSize(capacity) + (ledBrightness != nullptr ? capacity : 0);
+    bytes += pipelineEnabled ? 3 * pixelBytes : pixelBytes;
+    bytes += (wireBuffers[1] != nullptr) ? 2 * wireBufferSize : wireBufferSize;
+    bytes += (size_t)colorTableCount * 256 * sizeof(uint16_t);
+    if (gammaCurve != nullptr) {
+        bytes += 256 * sizeof(uint16_t);
+    }
+    bytes += (size_t)paletteSize * (colorComponentCount + sizeof(uint16_t));
+    if (powerZones != nullptr) {
+        bytes += MAX_POWER_ZONES * sizeof(PowerZone);
+    }
+    return bytes;
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
 /// @brief Gets the current number of LEDs.
 ///
-uint16_t ShiftLED::getNumLEDs() const {
+uint32_t ShiftLED::getNumLEDs() const {
     return this->numLEDs;
 }
 
@@ -247,169 +1659,598 @@ uint32_t ShiftLED::estimateDesiredPowerConsumption() const {
     return calculatePowerConsumption(desiredGlobalBrightness);
 }
 
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Estimates the power consumption in milliwatts (mW) at the given global brightness.
+///
+uint32_t ShiftLED::estimatePowerConsumption(uint8_t globalBrightness) const {
+    return calculatePowerConsumption(globalBrightness);
+}
+
 ///---------------------------------------------------------------------------------------------------------------------
 /// @brief Calculates the power consumption in milliwatts (mW) using the specified global brightness.
 ///
 uint32_t ShiftLED::calculatePowerConsumption(uint8_t globalBrightness) const {
-    uint32_t totalPower_mW = 0;
-    size_t colorComponentCount = colorOrder.size();
-
-    for (uint16_t i = 0; i < numLEDs; i++) {
-        uint8_t* p = &ledData[i * colorComponentCount];
-        uint8_t brightness = ledBrightness[i];
-
-        // Calculate per-LED brightness scaling (0.0 to 1.0)
-        float ledBrightnessScale = ((float)brightness * globalBrightness) / (255.0 * 255.0);
-
-        // Calculate average color intensity for the LED (0.0 to 1.0)
-        float colorIntensity = 0.0;
-        size_t activeComponents = 0;
-        for (size_t j = 0; j < colorComponentCount; ++j) {
-            // Exclude 'NONE' components from the calculation
-            if (colorOrder[j] != NONE) {
-                colorIntensity += p[j] / 255.0;
-                activeComponents++;
-            }
-        }
-        if (activeComponents > 0) {
-            // Average color intensity across all active components
-            colorIntensity /= activeComponents;
+    if (powerWeightSumStale) {
+        powerWeightSum = recomputePowerWeightSum();
+        powerWeightSumStale = false;
+    }
+
+#ifdef SHIFT_LED_DEBUG_POWER
+    uint64_t recomputed = recomputePowerWeightSum();
+    if (recomputed != powerWeightSum) {
+        Serial.print("Power weight sum mismatch: ");
+        Serial.print((uint32_t)powerWeightSum);
+        Serial.print(" != ");
+        Serial.println((uint32_t)recomputed);
+    }
+#endif
+
+    return scalePowerWeightSum(powerWeightSum, globalBrightness);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Converts a power weight sum into milliwatts (mW) at the specified global brightness.
+///
+uint32_t ShiftLED::scalePowerWeightSum(uint64_t weightSum, uint8_t globalBrightness) const {
+    if (activeComponentCount == 0) return 0;
+
+    // Each LED draws maxPowerPerLED_mW scaled by its brightness, the global brightness
+    // and the average intensity of its active components
+    // (split so that long strips cannot overflow the 64-bit product)
+    uint32_t factor = (uint32_t)maxPowerPerLED_mW * globalBrightness;
+    uint32_t divisor = (uint32_t)255 * 255 * 255 * activeComponentCount;
+    return weightSum / divisor * factor + weightSum % divisor * factor / divisor;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the power weight of a single LED (brightness * sum of active components).
+///
+uint32_t ShiftLED::getPowerWeight(uint32_t index) const {
+    // Palette entries carry a precomputed component sum
+    uint16_t colorSum = (storage == PIXEL_STORAGE_DIRECT) ? getColorSum(&ledData[index * colorComponentCount])
+                                                          : paletteWeights[getPaletteIndex(index)];
+    return (uint32_t)getLEDBrightness(index) * colorSum;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sums the active components of a color in the strip's color order.
+///
+uint16_t ShiftLED::getColorSum(const uint8_t* p) const {
+    uint16_t colorSum = 0;
+    for (uint8_t j = 0; j < colorComponentCount; ++j) {
+        // Exclude 'NONE' components from the calculation
+        if (colorOrder[j] != NONE) {
+            colorSum += p[j];
         }
+    }
+    return colorSum;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Recomputes the power weight sum from scratch.
+///
+uint64_t ShiftLED::recomputePowerWeightSum() const {
+    return sumPowerWeights(0, numLEDs);
+}
 
-        // Total intensity scaling
-        float totalIntensity = ledBrightnessScale * colorIntensity;
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sums the power weights of count LEDs starting at start.
+///
+uint64_t ShiftLED::sumPowerWeights(uint32_t start, uint32_t count) const {
+    uint64_t sum = 0;
+    for (uint32_t i = start; i < start + count; i++) {
+        sum += getPowerWeight(i);
+    }
+    return sum;
+}
 
-        // Estimate power for this LED
-        uint32_t ledPower_mW = (uint32_t)(maxPowerPerLED_mW * totalIntensity);
-        totalPower_mW += ledPower_mW;
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Updates the LEDs with the current color data.
+///
+void ShiftLED::update() {
+    if (chunkLEDs != 0) {
+        streamFrame();
+        waitForTransfer();
+        return;
     }
+    if (backend != nullptr) {
+        updateAsync();
+        waitForTransfer();
+        return;
+    }
+
+    // Expand the frame into SPI patterns before touching the bus
+    uint8_t* wireBuffer = wireBuffers[0];
+    uint32_t count = prepareFrame(wireBuffer);
+    if (count == 0) return; // Every LED already shows the current frame
+    uint32_t mark = statsTime();
+
+    // Only the part of the reset time that has not passed yet
+    waitForReset();
+    addStatsTime(STATS_PHASE_LATCH, mark);
 
-    return totalPower_mW;
+    // Gaps between bytes would be taken as a reset; clocked chips do not care
+    bool clocked = encoding == SPI_ENCODING_APA102;
+    if (!clocked) noInterrupts();
+
+    // Send pixel data in one bulk transfer (the buffer is overwritten with received data)
+    size_t length = getFrameLength(count);
+    SPI_peripheral.transfer(wireBuffer, length);
+    addStatsTime(STATS_PHASE_TRANSFER, mark);
+
+    endTransfer();
+
+    if (!clocked) interrupts();
+
+    addStatsTime(STATS_PHASE_LATCH, mark);
+    recordFrameStats(length + 1); // Reset byte
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Parses a color string and extracts color components.
+/// @brief Encodes the current color data and starts sending it without waiting for completion.
 ///
-bool ShiftLED::parseColorString(const String& colorString, uint8_t& red, uint8_t& green, uint8_t& blue,
-                                uint8_t& white, uint8_t& warmWhite, uint8_t& coldWhite) {
-    if (colorString.startsWith("#")) {
-        // Hex color code
-        if (colorString.length() == 7) { // Format: #RRGGBB
-            red   = strtol(colorString.substring(1, 3).c_str(), NULL, 16);
-            green = strtol(colorString.substring(3, 5).c_str(), NULL, 16);
-            blue  = strtol(colorString.substring(5, 7).c_str(), NULL, 16);
-            return true;
-        } else if (colorString.length() == 4) { // Format: #RGB
-            red   = strtol(colorString.substring(1, 2).c_str(), NULL, 16) * 17; // Duplicate hex digit
-            green = strtol(colorString.substring(2, 3).c_str(), NULL, 16) * 17;
-            blue  = strtol(colorString.substring(3, 4).c_str(), NULL, 16) * 17;
-            return true;
-        } else {
-            Serial.println("Invalid hex color format.");
-            return false;
+void ShiftLED::updateAsync() {
+    if (chunkLEDs != 0) {
+        // Returns once the last chunk is on the bus; a backend reports its completion
+        if (streamFrame() == 0 || backend == nullptr) {
+            if (frameCompleteCallback != nullptr) {
+                frameCompleteCallback(*this);
+            }
         }
-    } else if (colorString.endsWith("K") || colorString.endsWith("k")) {
-        // Kelvin temperature
-        uint16_t kelvin = colorString.substring(0, colorString.length() - 1).toInt();
-        kelvinToWarmCold(kelvin, warmWhite, coldWhite);
-        return true;
-    } else {
-        Serial.println("Unknown color format.");
+        return;
+    }
+    if (backend == nullptr) {
+        // Portable fallback: send blocking and report completion right away
+        update();
+        if (frameCompleteCallback != nullptr) {
+            frameCompleteCallback(*this);
+        }
+        return;
+    }
+
+    // Encode into the buffer that is not on the bus; ledData may be changed again once this returns
+    uint8_t backBuffer = frontBuffer ^ 1;
+    uint32_t count = prepareFrame(wireBuffers[backBuffer]);
+    if (count == 0) {
+        // Every LED already shows the current frame
+        if (frameCompleteCallback != nullptr) {
+            frameCompleteCallback(*this);
+        }
+        return;
+    }
+
+    // Wait for the previous frame and the remainder of its reset time
+    uint32_t mark = statsTime();
+    waitForTransfer();
+    waitForReset();
+    addStatsTime(STATS_PHASE_LATCH, mark);
+
+    frontBuffer = backBuffer;
+    transferActive = true;
+#ifdef SHIFT_LED_STATS
+    statsTransferStart_us = micros();
+#endif
+    size_t length = getFrameLength(count);
+    backend->startTransfer(wireBuffers[frontBuffer], length);
+    recordFrameStats(length);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Returns true while an asynchronous frame is still being sent.
+///
+bool ShiftLED::isBusy() {
+    if (!transferActive) return false;
+    if (backend->isBusy()) return true;
+
+    // The frame just completed; the reset time starts now
+    transferActive = false;
+    lastFrameEnd_us = micros();
+#ifdef SHIFT_LED_STATS
+    addStatsTime(STATS_PHASE_TRANSFER, statsTransferStart_us);
+#endif
+    if (frameCompleteCallback != nullptr) {
+        frameCompleteCallback(*this);
+    }
+    return false;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Splits the strip into a render side and an output side that may run on different cores.
+///
+bool ShiftLED::enablePipeline() {
+    if (storage != PIXEL_STORAGE_DIRECT) {
+        Serial.println("Pipeline requires direct pixel storage.");
+        return false;
+    }
+    if (pipelineEnabled) return true;
+    if (begun || callerBuffers.pixels != nullptr) {
+        Serial.println("Pipeline needs its own frames; enable it before begin() on a strip without caller buffers.");
         return false;
     }
+
+    waitForTransfer();
+    pipelineEnabled = true;
+    allocatePixels(); // All LEDs are off
+    return true;
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Converts a Kelvin temperature to warm and cold white components.
+/// @brief Hands the pixels written so far to the output side.
 ///
-void ShiftLED::kelvinToWarmCold(uint16_t kelvin, uint8_t& warmWhite, uint8_t& coldWhite) {
-    // Clamp kelvin to a reasonable range
-    kelvin = constrain(kelvin, 2000, 9000);
+void ShiftLED::publish() {
+    if (!pipelineEnabled) return;
+
+    // The power sum goes with the frame, so the output side can limit it without walking the pixels
+    if (powerWeightSumStale) {
+        powerWeightSum = recomputePowerWeightSum();
+        powerWeightSumStale = false;
+    }
+    PipelineFrame& frame = pipelineFrames[renderFrame];
+    frame.powerWeightSum = powerWeightSum;
 
-    // Normalize kelvin to a 0-1 range
-    float temp = (kelvin - 2000.0) / (9000.0 - 2000.0);
+    // Swap the frame in as the newest one; a published frame the output side never took comes back
+    uint8_t published = renderFrame;
+    uint8_t previous = __atomic_exchange_n(&pipelineState, (uint8_t)(published | PIPELINE_FRESH), __ATOMIC_ACQ_REL);
+    renderFrame = previous & PIPELINE_FRAME_MASK;
 
-    // Calculate warm and cold white intensities
-    warmWhite = (uint8_t)((1.0 - temp) * 255);
-    coldWhite = (uint8_t)(temp * 255);
+    // Keep drawing on top of the published frame; the output side only reads it
+    PipelineFrame& next = pipelineFrames[renderFrame];
+    memcpy(next.data, frame.data, (size_t)numLEDs * colorComponentCount);
+    memcpy(next.brightness, frame.brightness, numLEDs);
+    ledData = next.data;
+    ledBrightness = next.brightness;
+    dirtyEnd = 0;
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Updates the LEDs with the current color data.
+/// @brief Takes the newest published frame for sending; returns false if none was published since the last one.
 ///
-void ShiftLED::update() {
-    // Update actual global brightness based on power consumption
-    updateActualBrightness();
+bool ShiftLED::acquireFrame() {
+    // Only the output side clears the flag, so a frame published in between is simply taken instead
+    if (!(__atomic_load_n(&pipelineState, __ATOMIC_ACQUIRE) & PIPELINE_FRESH)) return false;
+    uint8_t previous = __atomic_exchange_n(&pipelineState, outputFrame, __ATOMIC_ACQ_REL);
+    outputFrame = previous & PIPELINE_FRAME_MASK;
+    return true;
+}
 
-    // Send initial reset code
-    SPI_peripheral.transfer(0x00);
-    delayMicroseconds(300); // Ensure data line is low for at least 50µs
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Enables sending only the pixels up to the last one modified since the previous frame.
+///
+void ShiftLED::setDirtyTracking(bool enabled) {
+    dirtyTracking = enabled;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the number of wire bytes skipped by dirty tracking since construction.
+///
+uint32_t ShiftLED::getBytesSaved() const {
+    return bytesSaved;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Updates the brightness, encodes the pixels that need sending and returns their count.
+///
+uint32_t ShiftLED::prepareFrame(uint8_t* out) {
+    uint32_t count = startFrame();
+    uint32_t mark = statsTime();
+
+    if (encoding == SPI_ENCODING_APA102) {
+        // Start frame, LED frames, then zero bytes that clock the data through the strip
+        size_t pixelBytes = (size_t)count * wireBytesPerLED;
+        memset(out, 0, 4);
+        encodeFrame(out + 4, 0, count);
+        memset(out + 4 + pixelBytes, 0, getFrameLength(count) - 4 - pixelBytes);
+    } else {
+        encodeFrame(out, 0, count);
+    }
+    addStatsTime(STATS_PHASE_ENCODE, mark);
+
+    finishFrame(count);
+    return count;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Updates the brightness and dithering and returns the number of pixels that need sending.
+///
+uint32_t ShiftLED::startFrame() {
+#ifdef SHIFT_LED_STATS
+    memset(stats.lastTime_us, 0, sizeof(stats.lastTime_us));
+#endif
+    uint32_t mark = statsTime();
 
-    noInterrupts(); // Disable interrupts during data transmission
+    // In pipeline mode the render side owns ledData; the output side sends its own frame
+    bool published = pipelineEnabled && acquireFrame();
+    frameData = pipelineEnabled ? pipelineFrames[outputFrame].data : ledData;
+    frameBrightness = pipelineEnabled ? pipelineFrames[outputFrame].brightness : ledBrightness;
 
-    size_t colorComponentCount = colorOrder.size();
+    // Update actual global brightness based on power consumption
+    updateActualBrightness();
 
-    // Send pixel data
-    for (uint16_t i = 0; i < numLEDs; i++) {
-        uint8_t* p = &ledData[i * colorComponentCount];
-        uint8_t brightness = ledBrightness[i];
+    // The tables only change with the brightness, gamma or white balance
+    if (colorTablesStale || actualGlobalBrightness != tableGlobalBrightness) {
+        buildColorTables();
+    }
 
-        // Send the pixel data
-        sendPixel(p, brightness);
+    if (dithering) {
+        // Bit-reversed frame counter: the rounding offset visits every fraction evenly over 256 frames
+        uint8_t frame = ditherFrame++;
+        frame = (frame & 0xF0) >> 4 | (frame & 0x0F) << 4;
+        frame = (frame & 0xCC) >> 2 | (frame & 0x33) << 2;
+        ditherOffset = (frame & 0xAA) >> 1 | (frame & 0x55) << 1;
     }
+    addStatsTime(STATS_PHASE_BRIGHTNESS, mark);
 
-    endTransfer();
+    // LEDs past the last modified one keep their latched color, unless the scaling changed.
+    // Dithered frames differ even where the pixels did not change.
+    // A published frame is sent whole, as the frames between it and the last one sent may have been skipped.
+    uint32_t count = pipelineEnabled ? 0 : dirtyEnd;
+    if (published || !dirtyTracking || fullRefreshPending || dithering ||
+        actualGlobalBrightness != sentGlobalBrightness) {
+        count = numLEDs;
+    }
+
+    // Power zones are measured whole: a zone the dirty range ends in is sent completely
+    for (uint8_t z = 0; z < powerZoneCount && count < numLEDs; z++) {
+        const PowerZone& zone = powerZones[z];
+        if (count > zone.start && count - zone.start < zone.count) {
+            count = (zone.count < numLEDs - zone.start) ? zone.start + zone.count : numLEDs;
+        }
+    }
 
-    interrupts(); // Re-enable interrupts
+    return count;
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Sends the color data for a single pixel.
+/// @brief Records a frame of count pixels as sent.
 ///
-void ShiftLED::sendPixel(uint8_t* colors, uint8_t brightness) {
-    size_t colorComponentCount = colorOrder.size();
+void ShiftLED::finishFrame(uint32_t count) {
+    bytesSaved += (uint32_t)(numLEDs - count) * wireBytesPerLED;
+    if (!pipelineEnabled) dirtyEnd = 0; // Otherwise it belongs to the render side
+    fullRefreshPending = false;
+    sentGlobalBrightness = actualGlobalBrightness;
+}
 
-    // Adjust brightness
-    uint8_t adjustedColors[8] = {0}; // Supports up to 8 color components
-    uint16_t totalBrightness = ((uint16_t)brightness * actualGlobalBrightness) / 255;
-    for (size_t i = 0; i < colorComponentCount; ++i) {
-        adjustedColors[i] = (colors[i] * totalBrightness) / 255;
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Encodes and sends a frame chunk by chunk; returns the number of pixels sent.
+///
+uint32_t ShiftLED::streamFrame() {
+    uint32_t count = startFrame();
+    if (count == 0) {
+        // Every LED already shows the current frame
+        finishFrame(0);
+        return 0;
     }
 
-    // Send color components, including 'NONE' components
-    for (size_t i = 0; i < colorComponentCount; ++i) {
-        uint8_t color = adjustedColors[i];
+    // The chunk buffers may still hold the end of the previous frame
+    uint32_t mark = statsTime();
+    waitForTransfer();
+    addStatsTime(STATS_PHASE_LATCH, mark);
+    if (powerZoneCount > 0) meterZones(count);
+    addStatsTime(STATS_PHASE_ENCODE, mark);
+    waitForReset();
+    addStatsTime(STATS_PHASE_LATCH, mark);
 
-        // Send each bit of the byte, MSB first
-        for (int8_t bit = 7; bit >= 0; bit--) {
-            if (color & (1 << bit)) {
-                one();
-            } else {
-                zero();
-            }
+    // Single-wire chips only stream through an asynchronous backend (see canStream()), so blocking chunks are clocked
+    bool clocked = encoding == SPI_ENCODING_APA102;
+    bool blocking = backend == nullptr;
+#ifdef SHIFT_LED_STATS
+    statsTransferStart_us = micros();
+#endif
+
+    // With a backend the two buffers form a ring: one chunk is encoded while the other is on the bus
+    uint8_t chunk = 0;
+    if (clocked) {
+        memset(wireBuffers[chunk], 0, 4);
+        sendChunk(wireBuffers[chunk], 4);
+        chunk = blocking ? 0 : chunk ^ 1;
+    }
+    for (uint32_t i = 0; i < count; i += chunkLEDs) {
+        uint32_t leds = (count - i < chunkLEDs) ? count - i : chunkLEDs;
+        encodeFrame(wireBuffers[chunk], i, leds);
+        sendChunk(wireBuffers[chunk], (size_t)leds * wireBytesPerLED);
+        chunk = blocking ? 0 : chunk ^ 1;
+    }
+    if (clocked) {
+        size_t tail = getFrameLength(count) - 4 - (size_t)count * wireBytesPerLED;
+        while (tail > 0) {
+            size_t length = (tail < wireBufferSize) ? tail : wireBufferSize;
+            memset(wireBuffers[chunk], 0, length);
+            sendChunk(wireBuffers[chunk], length);
+            chunk = blocking ? 0 : chunk ^ 1;
+            tail -= length;
         }
     }
+    finishFrame(count);
+
+    // Encoding overlaps the transfer and is counted with it
+    size_t length = getFrameLength(count);
+    if (blocking) {
+        addStatsTime(STATS_PHASE_TRANSFER, mark);
+        endTransfer();
+        addStatsTime(STATS_PHASE_LATCH, mark);
+        recordFrameStats(length + 1); // Reset byte
+    } else {
+        // The last chunk completes like an asynchronous frame
+        transferActive = true;
+        recordFrameStats(length);
+    }
+    return count;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sends one chunk of a streamed frame.
+///
+void ShiftLED::sendChunk(uint8_t* data, size_t length) {
+    if (backend == nullptr) {
+        SPI_peripheral.transfer(data, length);
+        return;
+    }
+
+    // The previous chunk was sent from the other buffer while this one was encoded
+    while (backend->isBusy()) {}
+    backend->startTransfer(data, length);
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Sends a logic '1' bit to the LEDs via SPI.
+/// @brief Measures the zones of a streamed frame in chunks and sets their encode scales.
 ///
-void ShiftLED::one() {
-    SPI_peripheral.transfer(0xF8);
+void ShiftLED::meterZones(uint32_t count) {
+    // A zone's scale must be known before its first chunk is sent, so each zone is encoded into a chunk
+    // buffer once to measure it, and once more at the reduced scale when it is over budget
+    for (uint8_t z = 0; z < powerZoneCount; z++) {
+        PowerZone& zone = powerZones[z];
+        if (zone.start >= count) break;
+        uint32_t zoneCount = (zone.count < count - zone.start) ? zone.count : count - zone.start;
+
+        uint16_t scale = 256;
+        uint32_t power = 0;
+        for (uint8_t pass = 0; pass < 2; pass++) {
+            zone.encodeScale = scale;
+            memset(zoneLevelSums, 0, sizeof(zoneLevelSums));
+            for (uint32_t i = 0; i < zoneCount; i += chunkLEDs) {
+                uint32_t leds = (zoneCount - i < chunkLEDs) ? zoneCount - i : chunkLEDs;
+                encodeFrame(wireBuffers[0], zone.start + i, leds);
+            }
+            power = calculateZonePower(zone, zoneLevelSums);
+            if (pass > 0) break;
+
+            zone.reading.desiredPower_mW = power;
+            if (zone.maxPower_mW == 0 || power <= zone.maxPower_mW) break;
+            scale = (uint64_t)zone.maxPower_mW * 256 / power;
+        }
+        zone.reading.power_mW = power;
+        zone.reading.scale = scale > 255 ? 255 : scale;
+    }
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Sends a logic '0' bit to the LEDs via SPI.
+/// @brief Encodes count pixels from start into the given wire buffer, without start or end frames.
 ///
-void ShiftLED::zero() {
-    SPI_peripheral.transfer(0xC0);
+void ShiftLED::encodeFrame(uint8_t* out, uint32_t start, uint32_t count) {
+    encodeFrameAs<0>(out, start, count);
 }
 
 ///---------------------------------------------------------------------------------------------------------------------
-/// @brief Ends the data transmission by sending a reset signal.
+/// @brief Ends the data transmission by pulling the data line low; the reset time starts now.
 ///
 void ShiftLED::endTransfer() {
-    // Send reset code
+    // The next frame waits for whatever is left of the reset time instead of a fixed delay here
     SPI_peripheral.transfer(0x00);
-    delayMicroseconds(300); // Ensure data line is low for at least 50µs
+    lastFrameEnd_us = micros();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Records a frame handed to the bus.
+///
+void ShiftLED::recordFrameStats(size_t wireBytes) {
+#ifdef SHIFT_LED_STATS
+    uint32_t now = micros();
+    if (stats.frames == 0) statsFirstFrame_us = now;
+    statsLastFrame_us = now;
+    stats.frames++;
+    stats.wireBytes += wireBytes;
+
+    // Power limiting lowers the actual brightness below the desired one
+    stats.lastClampDepth = desiredGlobalBrightness - actualGlobalBrightness;
+    if (stats.lastClampDepth != 0) {
+        stats.clampCount++;
+        statsClampDepthSum += stats.lastClampDepth;
+        if (stats.lastClampDepth > stats.maxClampDepth) stats.maxClampDepth = stats.lastClampDepth;
+    }
+
+    // In pipeline mode the render side owns the running sum; the frame sent carries its own
+    uint32_t power = pipelineEnabled
+                         ? scalePowerWeightSum(pipelineFrames[outputFrame].powerWeightSum, actualGlobalBrightness)
+                         : estimatePowerConsumption();
+    if (power < stats.minPower_mW) stats.minPower_mW = power;
+    if (power > stats.maxPower_mW) stats.maxPower_mW = power;
+    statsPowerSum_mW += power;
+#else
+    (void)wireBytes;
+#endif
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the frame timing and power limiter statistics.
+///
+ShiftLEDStats ShiftLED::getStats() const {
+    ShiftLEDStats result;
+    memset(&result, 0, sizeof(result));
+#ifdef SHIFT_LED_STATS
+    result = stats;
+    if (stats.frames > 1 && statsLastFrame_us != statsFirstFrame_us) {
+        result.fps = (stats.frames - 1) * 1000000.0f / (uint32_t)(statsLastFrame_us - statsFirstFrame_us);
+    }
+    if (stats.clampCount != 0) {
+        result.avgClampDepth = (float)statsClampDepthSum / stats.clampCount;
+    }
+    if (stats.frames != 0) {
+        result.avgPower_mW = statsPowerSum_mW / stats.frames;
+    } else {
+        result.minPower_mW = 0;
+    }
+#endif
+    return result;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Clears the statistics.
+///
+void ShiftLED::resetStats() {
+#ifdef SHIFT_LED_STATS
+    memset(&stats, 0, sizeof(stats));
+    stats.minPower_mW = 0xFFFFFFFF;
+    statsClampDepthSum = 0;
+    statsPowerSum_mW = 0;
+    statsFirstFrame_us = 0;
+    statsLastFrame_us = 0;
+    statsTransferStart_us = 0;
+#endif
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Prints the statistics, e.g. to Serial.
+///
+void ShiftLED::printStats(Print& out) const {
+#ifdef SHIFT_LED_STATS
+    static const char* const phaseNames[STATS_PHASE_COUNT] = {"Brightness", "Encode", "Latch", "Transfer"};
+    ShiftLEDStats current = getStats();
+
+    out.print("Frames: ");
+    out.print((unsigned long)current.frames);
+    out.print(" (");
+    out.print(current.fps);
+    out.println(" FPS)");
+
+    for (uint8_t phase = 0; phase < STATS_PHASE_COUNT; phase++) {
+        out.print(phaseNames[phase]);
+        out.print(": last ");
+        out.print((unsigned long)current.lastTime_us[phase]);
+        out.print(" us, total ");
+        out.print((unsigned long)(current.totalTime_us[phase] / 1000));
+        out.println(" ms");
+    }
+
+    out.print("Wire bytes: ");
+    out.println((unsigned long)current.wireBytes);
+
+    out.print("Power limit: ");
+    out.print((unsigned long)current.clampCount);
+    out.print(" clamped frames, depth last ");
+    out.print((unsigned int)current.lastClampDepth);
+    out.print(", max ");
+    out.print((unsigned int)current.maxClampDepth);
+    out.print(", avg ");
+    out.println(current.avgClampDepth);
+
+    out.print("Power: min ");
+    out.print((unsigned long)current.minPower_mW);
+    out.print(" mW, max ");
+    out.print((unsigned long)current.maxPower_mW);
+    out.print(" mW, avg ");
+    out.print((unsigned long)current.avgPower_mW);
+    out.println(" mW");
+#else
+    out.println("Statistics are disabled; define SHIFT_LED_STATS.");
+#endif
 }
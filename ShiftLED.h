@@ -5,7 +5,8 @@
 
 #include <Arduino.h>
 #include <SPI.h>
-#include <vector>
+#include "ShiftLEDBackend.h"
+#include "ShiftLEDColor.h"
 
 /// @brief Enumeration for color components.
 enum ColorComponent {
@@ -18,14 +19,124 @@ enum ColorComponent {
     NONE
 };
 
+/// @brief SPI encodings: SPI bits per LED data bit for the single-wire protocol, or the clocked protocol.
+enum SPIEncoding {
+    SPI_ENCODING_8BIT,  // 8 SPI bits per LED bit at 8 MHz (0xF8 / 0xC0)
+    SPI_ENCODING_4BIT,  // 4 SPI bits per LED bit at 4 MHz (0b1110 / 0b1000)
+    SPI_ENCODING_3BIT,  // 3 SPI bits per LED bit at 3 MHz (0b110 / 0b100)
+    SPI_ENCODING_APA102 // Clock and data lines (APA102/SK9822): one header byte plus one byte per component
+};
+
+/// @brief Pulse timing of an LED chip on the SPI data line.
+struct LEDTimingProfile {
+    const char* name;     // Chip name as accepted by the constructor
+    uint32_t clock_Hz;    // SPI clock with the 8-bit encoding; the denser encodings scale it down
+    uint8_t onePattern;   // SPI bits sent for a '1' with the 8-bit encoding, MSB first (0 for clocked chips)
+    uint8_t zeroPattern;  // SPI bits sent for a '0'; may only be high where onePattern is (0 for clocked chips)
+    uint16_t reset_us;    // Minimum low time that latches a frame
+};
+
+/// @brief Component layouts for raw pixel data passed to setPixels().
+enum PixelFormat {
+    PIXEL_FORMAT_RGB,    // 3 bytes per pixel: red, green, blue
+    PIXEL_FORMAT_RGBW,   // 4 bytes per pixel: red, green, blue, white
+    PIXEL_FORMAT_NATIVE  // Same layout as the strip's color order
+};
+
+/// @brief How the LED colors are stored.
+enum PixelStorage {
+    PIXEL_STORAGE_DIRECT,    // All color components per LED, in the strip's color order
+    PIXEL_STORAGE_PALETTE8,  // One 8-bit palette index per LED (up to 256 colors)
+    PIXEL_STORAGE_PALETTE4   // Two 4-bit palette indices per byte (up to 16 colors)
+};
+
+/// @brief Direct view of the native-order LED buffers.
+struct PixelBuffer {
+    uint8_t* data;        // Color components in the strip's color order, or palette indices
+    uint8_t* brightness;  // Per-LED brightness (0-255), or nullptr while every LED is at 255
+    uint32_t length;      // Number of LEDs
+    uint8_t stride;       // Bytes per LED in data; 0 for packed 4-bit indices (high nibble first)
+
+    // Gets the first color component of an LED.
+    uint8_t* operator[](uint32_t index) const { return data + (size_t)index * stride; }
+};
+
+/// @brief Current drawn by each color channel of one LED at full level.
+struct LEDChannelCurrent {
+    uint8_t red_mA;
+    uint8_t green_mA;
+    uint8_t blue_mA;
+    uint8_t white_mA;
+    uint8_t warmWhite_mA;
+    uint8_t coldWhite_mA;
+};
+
+/// @brief Caller-provided storage for a strip that never allocates its LED or wire buffers.
+struct ShiftLEDBuffers {
+    uint8_t* pixels;      // capacity x color components bytes
+    uint8_t* brightness;  // capacity bytes, or nullptr to go without per-LED brightness
+    uint8_t* wire;        // One encoded frame (or chunk); twice that with a backend
+    size_t wireSize;      // Size of wire in bytes
+    uint32_t capacity;    // Most LEDs the buffers hold
+
+    // Gets the wire bytes of one frame of leds LEDs, e.g. to size a static array.
+    static constexpr size_t frameSize(uint32_t leds, uint8_t componentCount,
+                                      SPIEncoding encoding = SPI_ENCODING_8BIT) {
+        return encoding == SPI_ENCODING_APA102 ? 8 + (size_t)leds * (componentCount + 1) + ((size_t)leds + 15) / 16
+             : (size_t)leds * componentCount * (encoding == SPI_ENCODING_8BIT ? 8
+                                                : encoding == SPI_ENCODING_4BIT ? 4 : 3);
+    }
+};
+
+/// @brief Power drawn by a power zone in the last frame.
+struct PowerZoneReading {
+    uint32_t power_mW;         // Estimated power after the zone's own limiting
+    uint32_t desiredPower_mW;  // Estimated power before it
+    uint8_t scale;             // Scale applied to the zone (255 = not limited)
+};
+
+/// @brief Phases of a frame measured by the statistics.
+enum StatsPhase {
+    STATS_PHASE_BRIGHTNESS,  // Power limiting and color table updates
+    STATS_PHASE_ENCODE,      // Expanding pixels into SPI patterns
+    STATS_PHASE_LATCH,       // Reset delays and waiting for the previous frame
+    STATS_PHASE_TRANSFER,    // Sending the frame; for asynchronous frames until completion is seen
+    STATS_PHASE_COUNT
+};
+
+/// @brief Frame timing and power limiter statistics; only collected when SHIFT_LED_STATS is defined.
+struct ShiftLEDStats {
+    uint32_t frames;                           // Frames sent
+    uint64_t totalTime_us[STATS_PHASE_COUNT];  // Cumulative time per phase
+    uint32_t lastTime_us[STATS_PHASE_COUNT];   // Time per phase in the last frame
+    float fps;                                 // Frame rate between the first and the last frame
+    uint64_t wireBytes;                        // Bytes sent, including reset bytes
+    uint32_t clampCount;                       // Frames in which the power limiter lowered the brightness
+    uint8_t lastClampDepth;                    // Desired minus actual global brightness in the last frame
+    uint8_t maxClampDepth;                     // Largest reduction so far
+    float avgClampDepth;                       // Average reduction over the clamped frames
+    uint32_t minPower_mW;                      // Estimated power per frame: minimum,
+    uint32_t maxPower_mW;                      // maximum
+    uint32_t avgPower_mW;                      // and average
+};
+
+class ShiftLED;
+
+/// @brief Callback invoked when an asynchronous frame has finished sending.
+typedef void (*FrameCompleteCallback)(ShiftLED& leds);
+
 /// @brief ShiftLED class for controlling addressable LEDs using SPI.
 class ShiftLED {
   public:
     // Constructor
-    ShiftLED(String ledTypeString, uint16_t numLEDs, uint8_t dataPin, SPIClass& SPI_peripheral = SPI);
+    ShiftLED(String ledTypeString, uint32_t numLEDs, uint8_t dataPin, SPIClass& SPI_peripheral = SPI);
+
+    // Constructor for caller-provided (e.g. static) buffers; the strip never allocates its LED or wire storage.
+    ShiftLED(String ledTypeString, uint32_t numLEDs, uint8_t dataPin, const ShiftLEDBuffers& buffers,
+             SPIClass& SPI_peripheral = SPI);
 
     // Destructor
-    ~ShiftLED();
+    virtual ~ShiftLED();
 
     // Initializes the ShiftLED object and begins SPI communication.
     void begin();
@@ -33,22 +144,115 @@ class ShiftLED {
     // Ends SPI communication and cleans up resources.
     void end();
 
+    // Selects the SPI encoding used on the wire. Call before begin(); returns false afterwards.
+    bool setEncoding(SPIEncoding encoding);
+
+    // Gets the SPI encoding used on the wire.
+    SPIEncoding getEncoding() const;
+
+    // Selects the timing of a known chip, keeping the color order. Call before begin().
+    bool setTimingProfile(String chipName);
+
+    // Selects a custom chip timing. Call before begin().
+    bool setTimingProfile(const LEDTimingProfile& profile);
+
+    // Gets the chip timing in use.
+    const LEDTimingProfile& getTimingProfile() const;
+
+    // Sends frames through a (DMA) backend instead of blocking SPI transfers. Call before begin(); returns false
+    // afterwards.
+    bool setBackend(ShiftLEDBackend* backend);
+
+    // Sets the callback invoked when an asynchronous frame has finished sending.
+    void setFrameCompleteCallback(FrameCompleteCallback callback);
+
+    // Encodes frames in chunks of this many LEDs just ahead of the transfer (0 = whole frame, the default).
+    // Call before begin(); returns false afterwards. Single-wire chips need an asynchronous backend; without one
+    // begin() falls back to whole frames.
+    bool setWireChunkSize(uint16_t ledsPerChunk);
+
     // Sets the color of a single LED using color components.
-    void setLEDColor(uint16_t index, uint8_t red, uint8_t green, uint8_t blue,
+    void setLEDColor(uint32_t index, uint8_t red, uint8_t green, uint8_t blue,
                      uint8_t white = 0, uint8_t warmWhite = 0, uint8_t coldWhite = 0,
                      uint8_t brightness = 255);
 
+    // Sets the color of a single LED using a color value.
+    void setLEDColor(uint32_t index, const LEDColor& color, uint8_t brightness = 255);
+
     // Sets the color of a single LED using a color string.
-    void setLEDColor(uint16_t index, const String& colorString, uint8_t brightness = 255);
+    void setLEDColor(uint32_t index, const char* colorString, uint8_t brightness = 255);
+
+    // Sets the color of a single LED using a color string.
+    void setLEDColor(uint32_t index, const String& colorString, uint8_t brightness = 255);
 
     // Sets the color of all LEDs using color components.
     void setAllLEDs(uint8_t red, uint8_t green, uint8_t blue,
                     uint8_t white = 0, uint8_t warmWhite = 0, uint8_t coldWhite = 0,
                     uint8_t brightness = 255);
 
+    // Sets the color of all LEDs using a color value.
+    void setAllLEDs(const LEDColor& color, uint8_t brightness = 255);
+
+    // Sets the color of all LEDs using a color string.
+    void setAllLEDs(const char* colorString, uint8_t brightness = 255);
+
     // Sets the color of all LEDs using a color string.
     void setAllLEDs(const String& colorString, uint8_t brightness = 255);
 
+    // Sets the color of count LEDs starting at start.
+    void fillRange(uint32_t start, uint32_t count, const LEDColor& color, uint8_t brightness = 255);
+
+    // Copies count packed pixels into the strip starting at start, remapping them to the color order.
+    void setPixels(uint32_t start, const uint8_t* pixels, uint32_t count,
+                   PixelFormat format = PIXEL_FORMAT_RGB, uint8_t brightness = 255);
+
+    // Copies count LEDs (color and brightness) from src to dst. The ranges may overlap.
+    void copyRange(uint32_t dst, uint32_t src, uint32_t count);
+
+    // Moves all LEDs by offset positions (towards the end if positive) and turns vacated LEDs off.
+    void shift(int32_t offset);
+
+    // Dims the color of every LED by amount/256 (255 = off); per-LED brightness is unchanged.
+    void fadeToBlack(uint8_t amount);
+
+    // Blends count native-order pixels into the strip starting at start (alpha 255 = replace).
+    void blendPixels(uint32_t start, const uint8_t* pixels, uint32_t count, uint8_t alpha);
+
+    // Adds count native-order pixels to the strip starting at start, saturating at 255.
+    void addPixels(uint32_t start, const uint8_t* pixels, uint32_t count);
+
+    // Fills count LEDs starting at start with one turn of the hue circle from startHue.
+    void fillRainbow(uint32_t start, uint32_t count, uint8_t startHue = 0, uint8_t brightness = 255);
+
+    // Fills count LEDs starting at start with a linear gradient between two colors.
+    void fillGradient(uint32_t start, uint32_t count, const LEDColor& from, const LEDColor& to,
+                      uint8_t brightness = 255);
+
+    // Gets direct access to the native-order LED buffers. Call markPixelsChanged() after writing.
+    PixelBuffer getPixelBuffer();
+
+    // Reports LEDs written through getPixelBuffer() so they are sent and counted for power.
+    void markPixelsChanged(uint32_t start, uint32_t count);
+
+    // Selects how LED colors are stored and clears the strip. Call before begin(); returns false afterwards.
+    // Palette modes keep up to paletteSize colors (0 = 16 or 256); entry 0 starts out black.
+    bool setPixelStorage(PixelStorage storage, uint16_t paletteSize = 0);
+
+    // Gets how LED colors are stored.
+    PixelStorage getPixelStorage() const;
+
+    // Sets the color of a palette entry; every LED using it changes with the next update().
+    void setPaletteColor(uint8_t entry, const LEDColor& color);
+
+    // Sets the palette entry of a single LED.
+    void setPaletteIndex(uint32_t index, uint8_t entry, uint8_t brightness = 255);
+
+    // Gets the number of color components per LED (bytes per pixel in PIXEL_FORMAT_NATIVE).
+    uint8_t getColorComponentCount() const;
+
+    // Gets the color component at a position in the color order (NONE past the last one).
+    ColorComponent getColorComponent(uint8_t position) const;
+
     // Sets the desired global brightness level (0-255).
     void setGlobalBrightness(uint8_t brightnessLevel);
 
@@ -58,14 +262,71 @@ class ShiftLED {
     // Sets the maximum power consumption per LED at full brightness.
     void setMaxPowerPerLED(uint16_t maxPowerPerLED_mW);
 
+    // Maximum number of power zones.
+    static const uint8_t MAX_POWER_ZONES = 8;
+
+    // Adds a power zone of count LEDs starting at start, limited to maxPower_mW (0 = only measured).
+    // Zones must be added in index order and may not overlap. The first zone allocates the zone table, so it
+    // must be added before begin(); clearPowerZones() keeps the table.
+    bool addPowerZone(uint32_t start, uint32_t count, uint32_t maxPower_mW);
+
+    // Adds a power zone whose power is computed from per-channel currents and the supply voltage.
+    bool addPowerZone(uint32_t start, uint32_t count, uint32_t maxPower_mW, const LEDChannelCurrent& current);
+
+    // Removes all power zones.
+    void clearPowerZones();
+
+    // Sets the supply voltage used with per-channel currents (default is 5000 mV).
+    void setSupplyVoltage(uint16_t supply_mV);
+
+    // Gets the number of power zones.
+    uint8_t getPowerZoneCount() const;
+
+    // Gets the power drawn by a zone in the last frame.
+    PowerZoneReading getPowerZoneReading(uint8_t zone) const;
+
     // Updates the LEDs with the current color data.
     void update();
 
-    // Changes the number of LEDs at runtime.
-    void setNumLEDs(uint16_t newNumLEDs);
+    // Encodes the current color data and starts sending it without waiting for completion.
+    void updateAsync();
+
+    // Returns true while an asynchronous frame is still being sent.
+    bool isBusy();
+
+    // Splits the strip into a render side (pixel writes and publish()) and an output side (update() and all
+    // settings) that may run on different cores. Requires direct storage; call before begin().
+    bool enablePipeline();
+
+    // Hands the pixels written so far to the output side; update() sends the newest published frame.
+    // Drawing continues on a copy of the published frame.
+    void publish();
+
+    // Enables sending only the pixels up to the last one modified since the previous frame (default on).
+    void setDirtyTracking(bool enabled);
+
+    // Gets the number of wire bytes skipped by dirty tracking since construction.
+    uint32_t getBytesSaved() const;
+
+    // Changes the number of LEDs at runtime. Within the capacity the pixels are kept and nothing is allocated;
+    // beyond it the storage grows before begin() and the call fails afterwards.
+    bool setNumLEDs(uint32_t newNumLEDs);
 
     // Gets the current number of LEDs.
-    uint16_t getNumLEDs() const;
+    uint32_t getNumLEDs() const;
+
+    // Makes room for up to capacity LEDs, keeping the pixels. Call before begin().
+    bool reserve(uint32_t capacity);
+
+    // Allocates the per-LED brightness array up front, every LED at 255. Otherwise it is allocated the first
+    // time a level other than 255 is set before begin(); after begin() such levels are ignored without it.
+    bool reserveBrightness();
+
+    // Gets the most LEDs the strip holds without allocating.
+    uint32_t getCapacity() const;
+
+    // Gets the bytes used by the strip, including its heap or caller-provided buffers.
+    size_t getMemoryFootprint() const;
 
     // Gets the actual global brightness level after power limiting.
     uint8_t getActualGlobalBrightness() const;
@@ -76,17 +337,121 @@ class ShiftLED {
     // Estimates the power consumption in milliwatts (mW) before brightness adjustment.
     uint32_t estimateDesiredPowerConsumption() const;
 
-  private:
-    uint16_t numLEDs;
+    // Estimates the power consumption in milliwatts (mW) at the given global brightness.
+    uint32_t estimatePowerConsumption(uint8_t globalBrightness) const;
+
+    // Gets the frame timing and power limiter statistics (all zero unless SHIFT_LED_STATS is defined).
+    ShiftLEDStats getStats() const;
+
+    // Clears the statistics.
+    void resetStats();
+
+    // Prints the statistics, e.g. to Serial.
+    void printStats(Print& out) const;
+
+    // Sets the gamma exponent of the output curve (1.0 = linear, 2.2-2.8 looks even to the eye).
+    // The curve is allocated by the first gamma other than 1.0, which must be set before begin().
+    bool setGamma(float gamma);
+
+    // Sets the per-channel white balance; each component scales its channel (255 = unchanged).
+    // A balance that differs between channels needs a table per channel and must be set before begin().
+    bool setColorCorrection(const LEDColor& correction);
+
+    // Enables temporal dithering to recover resolution at low brightness.
+    void setDithering(bool enabled);
+
+  protected:
+    // Maximum number of color components per LED.
+    static const uint8_t MAX_COLOR_COMPONENTS = 8;
+
+    // Largest LED count whose encoded frame and byte offsets fit in 32 bits.
+    static const uint32_t MAX_LEDS = 0xFFFFFFFFUL / (MAX_COLOR_COMPONENTS * 8 + 1);
+
+    // Constructor for a color order that is known at compile time.
+    ShiftLED(const ColorComponent* order, uint8_t componentCount, uint32_t numLEDs, uint8_t dataPin,
+             SPIClass& SPI_peripheral, const ShiftLEDBuffers* buffers = nullptr);
+
+    uint32_t numLEDs;
+    uint32_t capacity;               // LEDs the pixel and wire buffers hold
+    ShiftLEDBuffers callerBuffers;   // Caller-provided storage; all nullptr when the strip allocates its own
+    bool begun;                      // Between begin() and end(); nothing allocates
+    bool brightnessRefused;          // A per-LED brightness was ignored after begin() (reported once)
     uint8_t dataPin;
     uint8_t desiredGlobalBrightness; // Desired global brightness (0-255)
     uint8_t actualGlobalBrightness;  // Actual global brightness (0-255)
-    uint8_t* ledData;                // Stores color values sequentially
-    uint8_t* ledBrightness;          // Stores per-LED brightness levels (0-255)
+    uint8_t* ledData;                // Stores color values sequentially, or palette indices
+    uint8_t* ledBrightness;          // Stores per-LED brightness levels (0-255); nullptr while all are 255
     SPIClass& SPI_peripheral;
 
-    String ledType;
-    std::vector<ColorComponent> colorOrder;
+    SPIEncoding encoding;            // SPI bits per LED data bit
+    LEDTimingProfile timing;         // SPI clock, bit patterns and reset time of the chip
+    uint8_t encodeTable8Bit[16][4];  // Nibble-to-SPI-pattern table built from the chip's bit patterns
+    uint8_t* wireBuffers[2];         // Encoded frames or chunks; the second one is only allocated with a backend
+    uint8_t frontBuffer;             // Index of the wire buffer currently on the bus
+    size_t wireBufferSize;           // Size of an encoded frame (or chunk) in bytes
+    uint16_t chunkLEDs;              // LEDs encoded per chunk while streaming; 0 = whole frames
+
+    ShiftLEDBackend* backend;        // Asynchronous transport, or nullptr for blocking SPI transfers
+    FrameCompleteCallback frameCompleteCallback;
+    bool transferActive;             // A frame was handed to the backend and has not completed yet
+    uint32_t lastFrameEnd_us;        // Time the data line last went low after a frame
+    size_t wireBytesPerLED;          // Encoded size of one LED in bytes
+
+    bool dirtyTracking;              // Send only the modified prefix of the strip
+    bool fullRefreshPending;         // The whole strip must be sent with the next frame
+    uint32_t dirtyEnd;               // One past the highest index modified since the last frame
+    uint8_t sentGlobalBrightness;    // Actual global brightness of the last frame sent
+    uint32_t bytesSaved;             // Wire bytes skipped by dirty tracking
+
+    /// @brief One frame of the render/output pipeline.
+    struct PipelineFrame {
+        uint8_t* data;                   // Colors in the strip's color order
+        uint8_t* brightness;             // Per-LED brightness; always allocated
+        uint64_t powerWeightSum;         // Power weight sum when the frame was published
+    };
+
+    bool pipelineEnabled;
+    PipelineFrame pipelineFrames[3]; // Being drawn, newest published and being sent; each role owns one at a time
+    uint8_t renderFrame;             // Frame the render side draws into (ledData)
+    uint8_t outputFrame;             // Frame the output side sends
+    volatile uint8_t pipelineState;  // Newest published frame, plus PIPELINE_FRESH until the output side takes it
+    const uint8_t* frameData;        // Pixels of the frame being encoded: ledData, or the output frame
+    const uint8_t* frameBrightness;
+
+    PixelStorage storage;            // How ledData stores the LED colors
+    uint8_t* palette;                // Palette colors in the strip's color order
+    uint16_t* paletteWeights;        // Sum of the active components of each palette entry
+    uint16_t paletteSize;            // Number of palette entries (0 for direct storage)
+    uint16_t paletteUsed;            // Entries assigned so far; colors beyond the palette map to the nearest
+
+    float gamma;                     // Gamma exponent of the output curve (1.0 = linear)
+    uint16_t* gammaCurve;            // Gamma curve in 8.8 fixed point, built by setGamma(); nullptr when linear
+    LEDColor colorCorrection;        // Per-channel white balance (255 = unchanged)
+    bool dithering;                  // Vary the rounding offset from frame to frame
+    uint8_t ditherFrame;             // Frame counter driving the dither sequence
+    uint8_t ditherOffset;            // Added to table entries before dropping the fraction
+    uint16_t* colorTables;           // Brightness, gamma and white balance tables in 8.8 fixed point
+    uint8_t colorTableCount;         // Tables allocated; only grows, so rebuilding them never allocates again
+    const uint16_t* componentTables[MAX_COLOR_COMPONENTS]; // Table used by each component
+    bool colorTablesStale;           // Gamma or white balance changed since the tables were built
+    uint8_t tableGlobalBrightness;   // Actual global brightness the tables were built for
+
+#ifdef SHIFT_LED_STATS
+    ShiftLEDStats stats;             // Derived fields are filled in by getStats()
+    uint64_t statsClampDepthSum;     // Sum of the clamp depths
+    uint64_t statsPowerSum_mW;       // Sum of the estimated power per frame
+    uint32_t statsFirstFrame_us;     // Start of the first frame
+    uint32_t statsLastFrame_us;      // Start of the last frame
+    uint32_t statsTransferStart_us;  // Start of the asynchronous frame in flight
+#endif
+
+    ColorComponent colorOrder[MAX_COLOR_COMPONENTS]; // Component order on the wire
+    uint8_t colorComponentCount;     // Number of entries used in colorOrder
+    uint8_t activeComponentCount;    // Color components other than NONE
+
+    // Running sum of per-LED power weights (brightness * sum of active components)
+    mutable uint64_t powerWeightSum;
+    mutable bool powerWeightSumStale; // LEDs were written directly; recompute before use
 
     // Maximum allowed power consumption in milliwatts (mW).
     uint32_t maxAllowedPower_mW;
@@ -94,33 +459,415 @@ class ShiftLED {
     // Maximum power consumption per LED at full brightness (default is 300 mW).
     uint16_t maxPowerPerLED_mW;
 
+    /// @brief Index range with its own power budget.
+    struct PowerZone {
+        uint32_t start;
+        uint32_t count;
+        uint32_t maxPower_mW;                      // 0 = only measured
+        uint8_t current_mA[MAX_COLOR_COMPONENTS];  // Per component in wire order; all 0 = use maxPowerPerLED_mW
+        bool useCurrent;
+        uint16_t encodeScale;                      // Scale (8.8) metered before a streamed frame
+        PowerZoneReading reading;
+    };
+
+    PowerZone* powerZones;           // Allocated when the first zone is added
+    uint8_t powerZoneCount;
+    uint64_t zoneLevelSums[MAX_COLOR_COMPONENTS]; // Output levels of the zone being metered while streaming
+    uint16_t supplyVoltage_mV;       // Converts per-channel currents into power
+
     // Parses the LED type string and sets up configurations.
     bool parseLEDType(String ledTypeString);
 
-    // Parses a color string and extracts color components.
-    bool parseColorString(const String& colorString, uint8_t& red, uint8_t& green, uint8_t& blue,
-                          uint8_t& white, uint8_t& warmWhite, uint8_t& coldWhite);
-
-    // Converts a Kelvin temperature to warm and cold white components.
-    void kelvinToWarmCold(uint16_t kelvin, uint8_t& warmWhite, uint8_t& coldWhite);
-
-    // Sends a logic '1' bit to the LEDs via SPI.
-    void one();
-
-    // Sends a logic '0' bit to the LEDs via SPI.
-    void zero();
-
-    // Sends the color data for a single pixel.
-    void sendPixel(uint8_t* colors, uint8_t brightness);
-
-    // Ends the data transmission by sending a reset signal.
+    // Looks up the timing, color order and encoding of a known chip; returns nullptr for unknown names.
+    static const LEDTimingProfile* findChip(const String& chipName, const char** colorOrderString,
+                                            SPIEncoding* chipEncoding);
+
+    // Gets the SPI clock frequency in Hz for the selected encoding.
+    uint32_t getEncodingClock() const;
+
+    // Gets the SPI mode (0-3) for the selected encoding.
+    uint8_t getSPIMode() const;
+
+    // Gets the number of bytes on the wire for a frame of count LEDs.
+    size_t getFrameLength(uint32_t count) const;
+
+    // (Re)allocates the wire buffers for the current LED count and encoding.
+    void allocateWireBuffer();
+
+    // Checks whether frames can be sent in chunks without the strip latching between two of them.
+    bool canStream() const;
+
+    // Blocks until the frame in flight has been sent.
+    void waitForTransfer();
+
+    // Waits for the part of the reset time that has not passed since the last frame.
+    void waitForReset();
+
+    // Stores color components in the strip's color order.
+    void storeComponents(uint8_t* p, uint8_t red, uint8_t green, uint8_t blue,
+                         uint8_t white, uint8_t warmWhite, uint8_t coldWhite) const;
+
+    // Gets the brightness of an LED.
+    uint8_t getLEDBrightness(uint32_t index) const {
+        return ledBrightness != nullptr ? ledBrightness[index] : 255;
+    }
+
+    // Stores the brightness of count LEDs; the array is allocated the first time a level other than 255 is used
+    // before begin().
+    void storeBrightness(uint32_t start, uint32_t count, uint8_t brightness) {
+        if (ledBrightness == nullptr) {
+            if (brightness == 255) return;
+            allocateBrightness();
+            if (ledBrightness == nullptr) return; // No brightness buffer was provided
+        }
+        memset(&ledBrightness[start], brightness, count);
+    }
+
+    // Allocates (or takes the caller's) per-LED brightness array with every LED at 255.
+    void allocateBrightness();
+
+    // Gets the palette entry of an LED.
+    uint8_t getPaletteIndex(uint32_t index) const {
+        if (storage == PIXEL_STORAGE_PALETTE8) return ledData[index];
+        return (ledData[index >> 1] >> ((~index & 1) << 2)) & 0x0F;
+    }
+
+    // Stores the palette entry of an LED.
+    void storePaletteIndex(uint32_t index, uint8_t entry) {
+        if (storage == PIXEL_STORAGE_PALETTE8) {
+            ledData[index] = entry;
+        } else {
+            uint8_t shift = (~index & 1) << 2; // Even LEDs use the high nibble
+            ledData[index >> 1] = (ledData[index >> 1] & ~(0x0F << shift)) | ((entry & 0x0F) << shift);
+        }
+    }
+
+    // Finds the palette entry for a color in the strip's color order, adding it while entries are free.
+    uint8_t findPaletteEntry(const uint8_t* color);
+
+    // Copies the color of the LED at start to the following count - 1 LEDs.
+    void replicatePixel(uint32_t start, uint32_t count);
+
+    // Combines count stored pixels from start with native-order pixels; Add saturates, otherwise weight/256 blends.
+    template <bool Add>
+    void combinePixels(uint32_t start, const uint8_t* pixels, uint32_t count, uint16_t weight);
+
+    // Stores the color of an LED without updating brightness, dirty range or power sum.
+    void storeColor(uint32_t index, const LEDColor& color);
+
+    // Gets a timestamp for the statistics; 0 when they are disabled.
+    uint32_t statsTime() const {
+#ifdef SHIFT_LED_STATS
+        return micros();
+#else
+        return 0;
+#endif
+    }
+
+    // Adds the time since mark to a phase of the current frame and restarts mark.
+    void addStatsTime(StatsPhase phase, uint32_t& mark) {
+#ifdef SHIFT_LED_STATS
+        uint32_t now = micros();
+        stats.totalTime_us[phase] += now - mark;
+        stats.lastTime_us[phase] += now - mark;
+        mark = now;
+#else
+        (void)phase;
+        (void)mark;
+#endif
+    }
+
+    // Records a frame handed to the bus.
+    void recordFrameStats(size_t wireBytes);
+
+    // Marks an LED as modified since the last frame.
+    void markDirty(uint32_t index) {
+        if (index >= dirtyEnd) dirtyEnd = index + 1;
+    }
+
+    // Updates the brightness, encodes the pixels that need sending and returns their count.
+    uint32_t prepareFrame(uint8_t* out);
+
+    // Updates the brightness and dithering and returns the number of pixels that need sending.
+    uint32_t startFrame();
+
+    // Records a frame of count pixels as sent.
+    void finishFrame(uint32_t count);
+
+    // Encodes and sends a frame chunk by chunk; returns the number of pixels sent.
+    uint32_t streamFrame();
+
+    // Sends one chunk of a streamed frame.
+    void sendChunk(uint8_t* data, size_t length);
+
+    // Measures the zones of a streamed frame in chunks and sets their encode scales.
+    void meterZones(uint32_t count);
+
+    // Looks up the white balance of each component; returns true if all components share one value, which is
+    // then stored in correction[0].
+    bool lookUpCorrection(uint8_t* correction) const;
+
+    // Rebuilds the color tables for the actual global brightness.
+    void buildColorTables();
+
+    // Encodes count pixels from start into the given wire buffer, without start or end frames.
+    virtual void encodeFrame(uint8_t* out, uint32_t start, uint32_t count);
+
+    // Encodes pixels with the selected encoding; ComponentCount 0 uses colorComponentCount.
+    template <uint8_t ComponentCount>
+    void encodeFrameAs(uint8_t* out, uint32_t start, uint32_t count);
+
+    // Encodes count pixels from start with a fixed encoding, component count and palette index width
+    // (0 = direct storage) and returns the next output position. Metered scales the output levels by
+    // zoneScale (256 = unchanged) and adds them to levelSums per component.
+    template <SPIEncoding Encoding, uint8_t ComponentCount, uint8_t IndexBits, bool Metered>
+    uint8_t* encodePixels(uint8_t* out, uint32_t start, uint32_t count, uint16_t zoneScale,
+                          uint64_t* levelSums) const;
+
+    // Encodes count pixels from start zone by zone, scaling the zones that exceed their budget.
+    template <SPIEncoding Encoding, uint8_t ComponentCount, uint8_t IndexBits>
+    void encodeZones(uint8_t* out, uint32_t start, uint32_t count);
+
+    // Encodes pixels with a fixed encoding and component count for the selected storage.
+    template <SPIEncoding Encoding, uint8_t ComponentCount>
+    void encodeStorage(uint8_t* out, uint32_t start, uint32_t count);
+
+    // Encodes a single color byte and returns the next output position.
+    template <SPIEncoding Encoding>
+    static uint8_t* encodeByte(uint8_t color, uint8_t* out, const uint8_t (*table8Bit)[4]);
+
+    // Nibble-to-SPI-pattern tables for the fixed encodings; the 8-bit table depends on the chip.
+    static const uint16_t encodeTable4Bit[16];
+    static const uint16_t encodeTable3Bit[16];
+
+    // Color scale (8.8) that makes up for rounding a per-LED brightness up to a 5-bit hardware level.
+    static const uint16_t hardwareBrightnessScale[32];
+
+    // Ends the data transmission by pulling the data line low; the reset time starts now.
     void endTransfer();
 
     // Updates the actual global brightness based on estimated power consumption.
     void updateActualBrightness();
 
+    // Converts a power weight sum into milliwatts (mW) at the specified global brightness.
+    uint32_t scalePowerWeightSum(uint64_t weightSum, uint8_t globalBrightness) const;
+
     // Calculates the power consumption in milliwatts (mW) using the specified global brightness.
     uint32_t calculatePowerConsumption(uint8_t globalBrightness) const;
+
+    // Gets the power weight of a single LED (brightness * sum of active components).
+    uint32_t getPowerWeight(uint32_t index) const;
+
+    // Sums the active components of a color in the strip's color order.
+    uint16_t getColorSum(const uint8_t* p) const;
+
+    // Converts the output level sums of a zone into milliwatts.
+    uint32_t calculateZonePower(const PowerZone& zone, const uint64_t* levelSums) const;
+
+    // Sums the power weights of count LEDs starting at start.
+    uint64_t sumPowerWeights(uint32_t start, uint32_t count) const;
+
+    // Recomputes the power weight sum from scratch.
+    uint64_t recomputePowerWeightSum() const;
+
+  private:
+    // Shared by the type string constructors.
+    ShiftLED(String ledTypeString, uint32_t numLEDs, uint8_t dataPin, SPIClass& SPI_peripheral,
+             const ShiftLEDBuffers* buffers);
+
+    // Sets every member to its default; all other constructors delegate here.
+    ShiftLED(uint32_t numLEDs, uint8_t dataPin, SPIClass& SPI_peripheral);
+
+    // Counts the active components and allocates (or takes the caller's) LED and wire buffers.
+    void initialize(const ShiftLEDBuffers* buffers);
+
+    // Gets the bytes of pixel storage for count LEDs.
+    size_t getStorageSize(uint32_t count) const;
+
+    // (Re)allocates the pixel storage for the capacity, keeping the first keepLEDs LEDs and clearing the rest.
+    void allocatePixels(uint32_t keepLEDs = 0);
+
+    // Turns off count LEDs from start, e.g. after the strip has grown over them.
+    void clearPixels(uint32_t start, uint32_t count);
+
+    // Frees the pixel storage, including the pipeline frames.
+    void releasePixels();
+
+    // Takes the newest published frame for sending; returns false if none was published since the last one.
+    bool acquireFrame();
 };
 
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Encodes pixels with the selected encoding; ComponentCount 0 uses colorComponentCount.
+///
+template <uint8_t ComponentCount>
+void ShiftLED::encodeFrameAs(uint8_t* out, uint32_t start, uint32_t count) {
+    // Dispatch once per frame (or chunk) so the per-byte loop has no branches on the encoding
+    switch (encoding) {
+        case SPI_ENCODING_8BIT:   encodeStorage<SPI_ENCODING_8BIT, ComponentCount>(out, start, count); break;
+        case SPI_ENCODING_4BIT:   encodeStorage<SPI_ENCODING_4BIT, ComponentCount>(out, start, count); break;
+        case SPI_ENCODING_3BIT:   encodeStorage<SPI_ENCODING_3BIT, ComponentCount>(out, start, count); break;
+        case SPI_ENCODING_APA102: encodeStorage<SPI_ENCODING_APA102, ComponentCount>(out, start, count); break;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Encodes pixels with a fixed encoding and component count for the selected storage.
+///
+template <SPIEncoding Encoding, uint8_t ComponentCount>
+void ShiftLED::encodeStorage(uint8_t* out, uint32_t start, uint32_t count) {
+    switch (storage) {
+        case PIXEL_STORAGE_DIRECT:   encodeZones<Encoding, ComponentCount, 0>(out, start, count); break;
+        case PIXEL_STORAGE_PALETTE8: encodeZones<Encoding, ComponentCount, 8>(out, start, count); break;
+        case PIXEL_STORAGE_PALETTE4: encodeZones<Encoding, ComponentCount, 4>(out, start, count); break;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Encodes count pixels from start zone by zone, scaling the zones that exceed their budget.
+///
+template <SPIEncoding Encoding, uint8_t ComponentCount, uint8_t IndexBits>
+void ShiftLED::encodeZones(uint8_t* out, uint32_t start, uint32_t count) {
+    const uint32_t end = start + count;
+    uint32_t i = start;
+    for (uint8_t z = 0; z < powerZoneCount && i < end; z++) {
+        PowerZone& zone = powerZones[z];
+        if (zone.start >= end) break;
+        uint32_t zoneEnd = (zone.count < end - zone.start) ? zone.start + zone.count : end;
+        if (zoneEnd <= i) continue;
+
+        // LEDs between zones are not metered
+        if (i < zone.start) {
+            out = encodePixels<Encoding, ComponentCount, IndexBits, false>(out, i, zone.start - i, 256, nullptr);
+            i = zone.start;
+        }
+
+        if (chunkLEDs != 0) {
+            // Streamed frames are encoded a chunk at a time; meterZones() has set the scale beforehand
+            out = encodePixels<Encoding, ComponentCount, IndexBits, true>(out, i, zoneEnd - i, zone.encodeScale,
+                                                                          zoneLevelSums);
+            i = zoneEnd;
+            continue;
+        }
+
+        // The zone is measured while it is encoded, and encoded a second time only when it is over budget
+        uint64_t levelSums[MAX_COLOR_COMPONENTS] = {};
+        uint8_t* zoneOut = out;
+        out = encodePixels<Encoding, ComponentCount, IndexBits, true>(zoneOut, zone.start, zoneEnd - zone.start, 256,
+                                                                      levelSums);
+        uint32_t power = calculateZonePower(zone, levelSums);
+        uint16_t scale = 256;
+        zone.reading.desiredPower_mW = power;
+        if (zone.maxPower_mW != 0 && power > zone.maxPower_mW) {
+            scale = (uint64_t)zone.maxPower_mW * 256 / power;
+            memset(levelSums, 0, sizeof(levelSums));
+            encodePixels<Encoding, ComponentCount, IndexBits, true>(zoneOut, zone.start, zoneEnd - zone.start, scale,
+                                                                    levelSums);
+            power = calculateZonePower(zone, levelSums);
+        }
+        zone.reading.power_mW = power;
+        zone.reading.scale = scale > 255 ? 255 : scale;
+        i = zoneEnd;
+    }
+
+    if (i < end) {
+        encodePixels<Encoding, ComponentCount, IndexBits, false>(out, i, end - i, 256, nullptr);
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Encodes count pixels from start with a fixed encoding, component count and palette index width
+/// (0 = direct storage) and returns the next output position.
+///
+template <SPIEncoding Encoding, uint8_t ComponentCount, uint8_t IndexBits, bool Metered>
+uint8_t* ShiftLED::encodePixels(uint8_t* out, uint32_t start, uint32_t count, uint16_t zoneScale,
+                                uint64_t* levelSums) const {
+    const uint8_t componentCount = ComponentCount != 0 ? ComponentCount : colorComponentCount;
+    const uint8_t* pixels = frameData + (IndexBits == 0 ? (size_t)start * componentCount : 0);
+    const uint8_t* paletteColors = palette;
+    const uint8_t* brightness = frameBrightness;
+    const uint8_t offset = ditherOffset;
+    const uint8_t (*table8Bit)[4] = encodeTable8Bit;
+
+    // Local copies; stores through out could otherwise alias the members and force reloads
+    const uint16_t* tables[MAX_COLOR_COMPONENTS];
+    for (uint8_t c = 0; c < componentCount; ++c) {
+        tables[c] = componentTables[c];
+    }
+
+    const uint32_t end = start + count;
+    for (uint32_t i = start; i < end; i++) {
+        // Palette indices are expanded to their color only here
+        const uint8_t* colors;
+        if (IndexBits == 0) {
+            colors = pixels;
+            pixels += componentCount;
+        } else if (IndexBits == 8) {
+            colors = &paletteColors[pixels[i] * componentCount];
+        } else {
+            colors = &paletteColors[((pixels[i >> 1] >> ((~i & 1) << 2)) & 0x0F) * componentCount];
+        }
+
+        // Per-LED brightness as a multiply and shift; 255 leaves the color unchanged
+        uint16_t scale = (brightness != nullptr) ? (uint16_t)brightness[i] + 1 : 256;
+
+        uint8_t hardwareLevel = 31;
+        if (Encoding == SPI_ENCODING_APA102) {
+            // The brightness goes into the 5-bit hardware field, rounded up; the colors only make up the
+            // difference, so dim LEDs keep their full color depth
+            scale = 256;
+            if (brightness != nullptr) {
+                hardwareLevel = ((uint16_t)brightness[i] * 31 + 254) / 255;
+                scale = ((uint32_t)brightness[i] * hardwareBrightnessScale[hardwareLevel]) >> 8;
+            }
+            *out++ = 0xE0 | hardwareLevel;
+        }
+
+        // Global brightness, gamma and white balance come from the tables, including 'NONE' components
+        for (uint8_t c = 0; c < componentCount; ++c) {
+            uint16_t level = tables[c][(colors[c] * scale) >> 8];
+            if (Metered) {
+                level = ((uint32_t)level * zoneScale) >> 8;
+            }
+            uint8_t value = (level + offset) >> 8;
+            if (Metered) {
+                // Clocked chips draw current in proportion to the hardware level (summed in 1/31 steps)
+                levelSums[c] += (Encoding == SPI_ENCODING_APA102) ? (uint32_t)value * hardwareLevel : value;
+            }
+            out = encodeByte<Encoding>(value, out, table8Bit);
+        }
+    }
+    return out;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Encodes a single color byte, MSB first, and returns the next output position.
+///
+template <SPIEncoding Encoding>
+uint8_t* ShiftLED::encodeByte(uint8_t color, uint8_t* out, const uint8_t (*table8Bit)[4]) {
+    uint8_t high = color >> 4;
+    uint8_t low = color & 0x0F;
+
+    if (Encoding == SPI_ENCODING_8BIT) {
+        memcpy(out, table8Bit[high], 4);
+        memcpy(out + 4, table8Bit[low], 4);
+        return out + 8;
+    } else if (Encoding == SPI_ENCODING_APA102) {
+        *out = color;
+        return out + 1;
+    } else if (Encoding == SPI_ENCODING_4BIT) {
+        out[0] = encodeTable4Bit[high] >> 8;
+        out[1] = encodeTable4Bit[high] & 0xFF;
+        out[2] = encodeTable4Bit[low] >> 8;
+        out[3] = encodeTable4Bit[low] & 0xFF;
+        return out + 4;
+    } else {
+        uint32_t bits = ((uint32_t)encodeTable3Bit[high] << 12) | encodeTable3Bit[low];
+        out[0] = bits >> 16;
+        out[1] = (bits >> 8) & 0xFF;
+        out[2] = bits & 0xFF;
+        return out + 3;
+    }
+}
+
 #endif // SHIFT_LED_H
@@ -0,0 +1,265 @@
+// ShiftLEDAnimator.cpp
+
+#include "ShiftLEDAnimator.h"
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Constructor for ShiftLEDAnimator class.
+///
+ShiftLEDAnimator::ShiftLEDAnimator(ShiftLED& leds, uint16_t targetFPS)
+    : leds(leds), framePeriod_us(0), nextFrame_us(0), started(false), renderCallbackCount(0),
+      deadlineMissedCallback(nullptr), redrawTracks(false), frameCount(0), droppedFrames(0), missedDeadlines(0) {
+    for (uint8_t i = 0; i < MAX_TRACKS; i++) {
+        tracks[i].active = false;
+    }
+    setTargetFPS(targetFPS);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the target frame rate.
+///
+void ShiftLEDAnimator::setTargetFPS(uint16_t targetFPS) {
+    if (targetFPS == 0) targetFPS = 1;
+    framePeriod_us = 1000000UL / targetFPS;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Adds a callback that renders every frame.
+///
+bool ShiftLEDAnimator::addRenderCallback(RenderCallback callback) {
+    if (renderCallbackCount >= MAX_RENDER_CALLBACKS) {
+        Serial.println("Too many render callbacks.");
+        return false;
+    }
+    renderCallbacks[renderCallbackCount++] = callback;
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the callback invoked when a frame finished after its deadline.
+///
+void ShiftLEDAnimator::setDeadlineMissedCallback(DeadlineMissedCallback callback) {
+    this->deadlineMissedCallback = callback;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Animates count LEDs starting at start through the keyframes; returns the track ID or -1.
+///
+int8_t ShiftLEDAnimator::addTrack(uint32_t start, uint32_t count, const LEDKeyframe* keyframes,
+                                  uint8_t keyframeCount, AnimationEasing easing, bool loop) {
+    if (keyframes == nullptr || keyframeCount == 0) {
+        Serial.println("Invalid keyframes.");
+        return -1;
+    }
+    for (uint8_t i = 1; i < keyframeCount; i++) {
+        if (keyframes[i].time_ms < keyframes[i - 1].time_ms) {
+            Serial.println("Keyframe times must not decrease.");
+            return -1;
+        }
+    }
+
+    for (uint8_t i = 0; i < MAX_TRACKS; i++) {
+        Track& track = tracks[i];
+        if (track.active) continue;
+
+        track.keyframes = keyframes;
+        track.keyframeCount = keyframeCount;
+        track.segment = 0;
+        track.start = start;
+        track.count = count;
+        track.easing = easing;
+        track.loop = loop;
+        track.active = true;
+        track.written = false;
+        // Time zero is the next frame, so the first keyframe is always shown
+        track.start_us = started ? nextFrame_us : micros();
+        track.elapsed_ms = 0;
+        return i;
+    }
+
+    Serial.println("Too many tracks.");
+    return -1;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Stops a track; its LEDs keep their current color.
+///
+void ShiftLEDAnimator::stopTrack(int8_t track) {
+    if (track < 0 || track >= MAX_TRACKS) return;
+    tracks[track].active = false;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Returns true while a track is running.
+///
+bool ShiftLEDAnimator::isTrackActive(int8_t track) const {
+    if (track < 0 || track >= MAX_TRACKS) return false;
+    return tracks[track].active;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Renders and sends a frame if one is due; returns true if a frame was sent.
+///
+bool ShiftLEDAnimator::run() {
+    uint32_t now = micros();
+    if (!started) {
+        nextFrame_us = now;
+        started = true;
+    }
+
+    int32_t late_us = (int32_t)(now - nextFrame_us);
+    if (late_us < 0) return false; // Not due yet
+
+    // Skip the slots that already passed instead of rendering a burst of late frames
+    if ((uint32_t)late_us >= framePeriod_us) {
+        uint32_t skipped = (uint32_t)late_us / framePeriod_us;
+        droppedFrames += skipped;
+        nextFrame_us += skipped * framePeriod_us;
+    }
+
+    // Frames are timed on the fixed grid, so jitter in run() calls does not show in the animation
+    uint32_t frame_us = nextFrame_us;
+    uint32_t deadline_us = frame_us + framePeriod_us;
+    nextFrame_us = deadline_us;
+
+    for (uint8_t i = 0; i < renderCallbackCount; i++) {
+        renderCallbacks[i](leds, frameCount);
+    }
+
+    // Only active tracks are evaluated, and only changed values are written
+    redrawTracks = renderCallbackCount > 0;
+    for (uint8_t i = 0; i < MAX_TRACKS; i++) {
+        if (tracks[i].active) {
+            applyTrack(tracks[i], frame_us);
+        }
+    }
+
+    // In pipeline mode the frame goes to the output side first
+    leds.publish();
+    leds.updateAsync();
+    frameCount++;
+
+    int32_t overrun_us = (int32_t)(micros() - deadline_us);
+    if (overrun_us > 0) {
+        missedDeadlines++;
+        if (deadlineMissedCallback != nullptr) {
+            deadlineMissedCallback(frameCount - 1, overrun_us);
+        }
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Writes the interpolated state of a track at the given frame time.
+///
+void ShiftLEDAnimator::applyTrack(Track& track, uint32_t frame_us) {
+    const LEDKeyframe* keyframes = track.keyframes;
+    const LEDKeyframe& last = keyframes[track.keyframeCount - 1];
+    // micros() wraps every 71.6 minutes: whole milliseconds move from start_us to elapsed_ms each frame
+    uint32_t step_ms = (frame_us - track.start_us) / 1000;
+    track.start_us += step_ms * 1000;
+    track.elapsed_ms += step_ms;
+    uint32_t elapsed_ms = track.elapsed_ms;
+
+    // A single keyframe has nothing to interpolate from and is held right away
+    if (elapsed_ms >= last.time_ms || track.keyframeCount == 1) {
+        if (!track.loop || last.time_ms == 0 || track.keyframeCount == 1) {
+            // Hold the last keyframe and retire the track
+            writeTrack(track, last.color, last.brightness);
+            track.active = false;
+            return;
+        }
+        // Move the start forward by whole loop periods
+        track.elapsed_ms %= last.time_ms;
+        elapsed_ms = track.elapsed_ms;
+    }
+
+    // Segments only move forward, except when a loop wraps around
+    if (elapsed_ms < keyframes[track.segment].time_ms) {
+        track.segment = 0;
+    }
+    while (track.segment + 2 < track.keyframeCount && elapsed_ms >= keyframes[track.segment + 1].time_ms) {
+        track.segment++;
+    }
+
+    const LEDKeyframe& from = keyframes[track.segment];
+    const LEDKeyframe& to = keyframes[track.segment + 1];
+    uint16_t t = 0;
+    if (elapsed_ms > from.time_ms) {
+        uint32_t span_ms = to.time_ms - from.time_ms;
+        t = (uint64_t)(elapsed_ms - from.time_ms) * 65535 / span_ms;
+    }
+    t = ease(t, track.easing);
+
+    LEDColor color(interpolate(from.color.red, to.color.red, t),
+                   interpolate(from.color.green, to.color.green, t),
+                   interpolate(from.color.blue, to.color.blue, t),
+                   interpolate(from.color.white, to.color.white, t),
+                   interpolate(from.color.warmWhite, to.color.warmWhite, t),
+                   interpolate(from.color.coldWhite, to.color.coldWhite, t));
+    writeTrack(track, color, interpolate(from.brightness, to.brightness, t));
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Writes a color to the LEDs of a track unless they already show it.
+///
+void ShiftLEDAnimator::writeTrack(Track& track, const LEDColor& color, uint8_t brightness) {
+    const LEDColor& last = track.lastColor;
+    if (track.written && !redrawTracks && brightness == track.lastBrightness &&
+        color.red == last.red && color.green == last.green && color.blue == last.blue &&
+        color.white == last.white && color.warmWhite == last.warmWhite && color.coldWhite == last.coldWhite) {
+        return; // Slow fades change only every few frames; unchanged LEDs stay out of the dirty range
+    }
+
+    leds.fillRange(track.start, track.count, color, brightness);
+    track.lastColor = color;
+    track.lastBrightness = brightness;
+    track.written = true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Maps linear progress (0-65535) through an easing curve.
+///
+uint16_t ShiftLEDAnimator::ease(uint16_t t, AnimationEasing easing) {
+    uint32_t inverse = 65535 - t;
+    switch (easing) {
+        case EASING_EASE_IN:     return ((uint32_t)t * t) >> 16;
+        case EASING_EASE_OUT:    return 65535 - ((inverse * inverse) >> 16);
+        case EASING_EASE_IN_OUT: {
+            // Smoothstep: t^2 * (3 - 2t)
+            uint64_t square = ((uint32_t)t * t) >> 16;
+            return (square * ((3UL << 16) - 2UL * t)) >> 16;
+        }
+        case EASING_LINEAR:
+        default:                 return t;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Interpolates between two component values with progress 0-65535.
+///
+uint8_t ShiftLEDAnimator::interpolate(uint8_t from, uint8_t to, uint16_t t) {
+    // Map 65535 to 65536 so the end value is reached exactly, then scale with a shift
+    int32_t scale = (int32_t)t + (t >> 15);
+    return from + ((((int32_t)to - from) * scale) >> 16);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the number of frames sent.
+///
+uint32_t ShiftLEDAnimator::getFrameCount() const {
+    return frameCount;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the number of frame slots skipped because rendering fell behind.
+///
+uint32_t ShiftLEDAnimator::getDroppedFrames() const {
+    return droppedFrames;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the number of frames that finished after their deadline.
+///
+uint32_t ShiftLEDAnimator::getMissedDeadlines() const {
+    return missedDeadlines;
+}
@@ -0,0 +1,122 @@
+// ShiftLEDAnimator.h
+
+#ifndef SHIFT_LED_ANIMATOR_H
+#define SHIFT_LED_ANIMATOR_H
+
+#include "ShiftLED.h"
+
+/// @brief Interpolation curve between two keyframes.
+enum AnimationEasing {
+    EASING_LINEAR,
+    EASING_EASE_IN,     // Starts slow (quadratic)
+    EASING_EASE_OUT,    // Ends slow (quadratic)
+    EASING_EASE_IN_OUT  // Starts and ends slow (smoothstep)
+};
+
+/// @brief Color and brightness of a track at a point in time. Brightness other than 255 needs the strip's
+/// per-LED brightness array (ShiftLED::reserveBrightness() before begin()).
+struct LEDKeyframe {
+    uint32_t time_ms;   // Time since the start of the track
+    LEDColor color;
+    uint8_t brightness;
+};
+
+/// @brief Callback that renders a frame into the strip before the keyframe tracks are applied.
+typedef void (*RenderCallback)(ShiftLED& leds, uint32_t frameNumber);
+
+/// @brief Callback invoked when a frame finished after its deadline.
+typedef void (*DeadlineMissedCallback)(uint32_t frameNumber, uint32_t late_us);
+
+/// @brief Fixed-rate frame scheduler with render callbacks and keyframe tracks.
+///
+/// Call run() from loop(). Frames are scheduled on a fixed grid at the target rate; when rendering falls
+/// behind by more than a frame, the missed slots are dropped instead of being rendered late.
+class ShiftLEDAnimator {
+  public:
+    // Maximum number of render callbacks.
+    static const uint8_t MAX_RENDER_CALLBACKS = 4;
+
+    // Maximum number of keyframe tracks.
+    static const uint8_t MAX_TRACKS = 8;
+
+    // Constructor
+    ShiftLEDAnimator(ShiftLED& leds, uint16_t targetFPS = 60);
+
+    // Sets the target frame rate.
+    void setTargetFPS(uint16_t targetFPS);
+
+    // Adds a callback that renders every frame.
+    bool addRenderCallback(RenderCallback callback);
+
+    // Sets the callback invoked when a frame finished after its deadline.
+    void setDeadlineMissedCallback(DeadlineMissedCallback callback);
+
+    // Animates count LEDs starting at start through the keyframes; returns the track ID or -1.
+    // Keyframe times must not decrease; a single keyframe is held. The keyframes are not copied and must outlive
+    // the track.
+    int8_t addTrack(uint32_t start, uint32_t count, const LEDKeyframe* keyframes, uint8_t keyframeCount,
+                    AnimationEasing easing = EASING_LINEAR, bool loop = false);
+
+    // Stops a track; its LEDs keep their current color.
+    void stopTrack(int8_t track);
+
+    // Returns true while a track is running.
+    bool isTrackActive(int8_t track) const;
+
+    // Renders and sends a frame if one is due; returns true if a frame was sent.
+    bool run();
+
+    // Gets the number of frames sent.
+    uint32_t getFrameCount() const;
+
+    // Gets the number of frame slots skipped because rendering fell behind.
+    uint32_t getDroppedFrames() const;
+
+    // Gets the number of frames that finished after their deadline.
+    uint32_t getMissedDeadlines() const;
+
+  private:
+    /// @brief Keyframe playback state.
+    struct Track {
+        const LEDKeyframe* keyframes;
+        uint8_t keyframeCount;
+        uint8_t segment;         // Index of the keyframe the current segment starts at
+        uint32_t start;
+        uint32_t count;
+        AnimationEasing easing;
+        bool loop;
+        bool active;
+        bool written;            // lastColor/lastBrightness hold what the LEDs show
+        uint32_t start_us;       // Frame time elapsed_ms counts from; moves forward every frame
+        uint32_t elapsed_ms;     // Track time at start_us, so tracks can outlast the micros() wrap
+        LEDColor lastColor;
+        uint8_t lastBrightness;
+    };
+
+    ShiftLED& leds;
+    uint32_t framePeriod_us;
+    uint32_t nextFrame_us;       // Scheduled start of the next frame
+    bool started;                // The first frame has been scheduled
+    RenderCallback renderCallbacks[MAX_RENDER_CALLBACKS];
+    uint8_t renderCallbackCount;
+    DeadlineMissedCallback deadlineMissedCallback;
+    Track tracks[MAX_TRACKS];
+    bool redrawTracks;           // Render callbacks may have overwritten the tracks' LEDs
+    uint32_t frameCount;
+    uint32_t droppedFrames;
+    uint32_t missedDeadlines;
+
+    // Writes the interpolated state of a track at the given frame time.
+    void applyTrack(Track& track, uint32_t frame_us);
+
+    // Writes a color to the LEDs of a track unless they already show it.
+    void writeTrack(Track& track, const LEDColor& color, uint8_t brightness);
+
+    // Maps linear progress (0-65535) through an easing curve.
+    static uint16_t ease(uint16_t t, AnimationEasing easing);
+
+    // Interpolates between two component values with progress 0-65535.
+    static uint8_t interpolate(uint8_t from, uint8_t to, uint16_t t);
+};
+
+#endif // SHIFT_LED_ANIMATOR_H
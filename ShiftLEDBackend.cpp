@@ -0,0 +1,250 @@
+// ShiftLEDBackend.cpp
+
+#include "ShiftLEDBackend.h"
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Constructor for the portable SPIClass backend.
+///
+ShiftLEDSPIBackend::ShiftLEDSPIBackend(SPIClass& SPI_peripheral) : SPI_peripheral(SPI_peripheral) {}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Begins SPI communication at the given clock and mode.
+///
+void ShiftLEDSPIBackend::begin(uint32_t clockHz, size_t maxLength, uint8_t spiMode) {
+    (void)maxLength;
+    const uint8_t modes[] = {SPI_MODE0, SPI_MODE1, SPI_MODE2, SPI_MODE3};
+    SPI_peripheral.begin();
+    SPI_peripheral.beginTransaction(SPISettings(clockHz, MSBFIRST, modes[spiMode & 3]));
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Ends SPI communication.
+///
+void ShiftLEDSPIBackend::end() {
+    SPI_peripheral.endTransaction();
+    SPI_peripheral.end();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sends the frame. Returns once the last byte is out, so the transfer is never busy afterwards.
+///
+void ShiftLEDSPIBackend::startTransfer(uint8_t* data, size_t length) {
+    noInterrupts(); // Gaps between bytes would be taken as a reset
+    SPI_peripheral.transfer(data, length);
+    interrupts();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Returns true while a frame is still being sent.
+///
+bool ShiftLEDSPIBackend::isBusy() {
+    return false;
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Constructor for the ESP32 DMA backend.
+///
+ShiftLEDESP32Backend::ShiftLEDESP32Backend(uint8_t dataPin, spi_host_device_t host, int8_t clockPin)
+    : dataPin(dataPin), clockPin(clockPin), host(host), device(nullptr), queued(false) {}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Initializes the SPI bus with DMA and adds an output-only device.
+///
+void ShiftLEDESP32Backend::begin(uint32_t clockHz, size_t maxLength, uint8_t spiMode) {
+    spi_bus_config_t busConfig = {};
+    busConfig.mosi_io_num = dataPin;
+    busConfig.miso_io_num = -1;
+    busConfig.sclk_io_num = clockPin;
+    busConfig.quadwp_io_num = -1;
+    busConfig.quadhd_io_num = -1;
+    busConfig.max_transfer_sz = maxLength;
+    if (spi_bus_initialize(host, &busConfig, SPI_DMA_CH_AUTO) != ESP_OK) {
+        Serial.println("Failed to initialize SPI bus for DMA.");
+        return;
+    }
+
+    spi_device_interface_config_t deviceConfig = {};
+    deviceConfig.clock_speed_hz = clockHz;
+    deviceConfig.mode = spiMode;
+    deviceConfig.spics_io_num = -1;
+    deviceConfig.queue_size = 1;
+    if (spi_bus_add_device(host, &deviceConfig, &device) != ESP_OK) {
+        Serial.println("Failed to add SPI device.");
+        device = nullptr;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Removes the device and frees the SPI bus.
+///
+void ShiftLEDESP32Backend::end() {
+    if (device == nullptr) return;
+    while (isBusy()) {}
+    spi_bus_remove_device(device);
+    spi_bus_free(host);
+    device = nullptr;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Queues the frame for DMA transmission. The buffer must be in DMA-capable memory.
+///
+void ShiftLEDESP32Backend::startTransfer(uint8_t* data, size_t length) {
+    if (device == nullptr) return;
+    memset(&transaction, 0, sizeof(transaction));
+    transaction.length = length * 8; // In bits
+    transaction.tx_buffer = data;
+    queued = spi_device_queue_trans(device, &transaction, portMAX_DELAY) == ESP_OK;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Returns true while a frame is still being sent.
+///
+bool ShiftLEDESP32Backend::isBusy() {
+    if (!queued) return false;
+
+    spi_transaction_t* result;
+    if (spi_device_get_trans_result(device, &result, 0) == ESP_OK) {
+        queued = false;
+    }
+    return queued;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Returns true: the DMA engine sends the frame after startTransfer() returns.
+///
+bool ShiftLEDESP32Backend::isAsynchronous() const {
+    return true;
+}
+#endif
+
+#if defined(ARDUINO_ARCH_RP2040)
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Constructor for the RP2040 DMA backend.
+///
+ShiftLEDRP2040Backend::ShiftLEDRP2040Backend(uint8_t dataPin, spi_inst_t* spi, int8_t clockPin)
+    : dataPin(dataPin), clockPin(clockPin), spi(spi), dmaChannel(-1) {}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Initializes the SPI peripheral and claims a DMA channel paced by its TX request.
+///
+void ShiftLEDRP2040Backend::begin(uint32_t clockHz, size_t maxLength, uint8_t spiMode) {
+    (void)maxLength;
+    spi_init(spi, clockHz);
+    spi_set_format(spi, 8, (spi_cpol_t)(spiMode >> 1), (spi_cpha_t)(spiMode & 1), SPI_MSB_FIRST);
+    gpio_set_function(dataPin, GPIO_FUNC_SPI);
+    if (clockPin >= 0) {
+        gpio_set_function(clockPin, GPIO_FUNC_SPI);
+    }
+
+    dmaChannel = dma_claim_unused_channel(true);
+    dmaConfig = dma_channel_get_default_config(dmaChannel);
+    channel_config_set_transfer_data_size(&dmaConfig, DMA_SIZE_8);
+    channel_config_set_read_increment(&dmaConfig, true);
+    channel_config_set_write_increment(&dmaConfig, false);
+    channel_config_set_dreq(&dmaConfig, spi_get_dreq(spi, true));
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Releases the DMA channel and the SPI peripheral.
+///
+void ShiftLEDRP2040Backend::end() {
+    if (dmaChannel < 0) return;
+    while (isBusy()) {}
+    dma_channel_unclaim(dmaChannel);
+    spi_deinit(spi);
+    dmaChannel = -1;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Starts the DMA transfer into the SPI data register.
+///
+void ShiftLEDRP2040Backend::startTransfer(uint8_t* data, size_t length) {
+    if (dmaChannel < 0) return;
+    dma_channel_configure(dmaChannel, &dmaConfig, &spi_get_hw(spi)->dr, data, length, true);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Returns true while a frame is still being sent.
+///
+bool ShiftLEDRP2040Backend::isBusy() {
+    if (dmaChannel < 0) return false;
+    if (dma_channel_is_busy(dmaChannel) || spi_is_busy(spi)) return true;
+
+    // Nothing reads the RX FIFO during the transfer; drain it and clear the overrun flag
+    while (spi_is_readable(spi)) {
+        (void)spi_get_hw(spi)->dr;
+    }
+    spi_get_hw(spi)->icr = SPI_SSPICR_RORIC_BITS;
+    return false;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Returns true: the DMA engine sends the frame after startTransfer() returns.
+///
+bool ShiftLEDRP2040Backend::isAsynchronous() const {
+    return true;
+}
+#endif
+
+#if defined(SHIFT_LED_HAS_SAMD_DMA)
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Constructor for the SAMD DMA backend.
+///
+ShiftLEDSAMDBackend::ShiftLEDSAMDBackend(SPIClass& SPI_peripheral, Sercom* sercom, uint8_t dmacTrigger)
+    : SPI_peripheral(SPI_peripheral), sercom(sercom), dmacTrigger(dmacTrigger), descriptor(nullptr) {}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Begins SPI communication and allocates a DMA channel triggered by the SERCOM TX request.
+///
+void ShiftLEDSAMDBackend::begin(uint32_t clockHz, size_t maxLength, uint8_t spiMode) {
+    (void)maxLength;
+    const uint8_t modes[] = {SPI_MODE0, SPI_MODE1, SPI_MODE2, SPI_MODE3};
+    SPI_peripheral.begin();
+    SPI_peripheral.beginTransaction(SPISettings(clockHz, MSBFIRST, modes[spiMode & 3]));
+
+    if (dma.allocate() != DMA_STATUS_OK) {
+        Serial.println("Failed to allocate DMA channel.");
+        return;
+    }
+    dma.setTrigger(dmacTrigger);
+    dma.setAction(DMA_TRIGGER_ACTON_BEAT);
+    descriptor = dma.addDescriptor(nullptr, (void*)&sercom->SPI.DATA.reg, 0, DMA_BEAT_SIZE_BYTE, true, false);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Releases the DMA channel and ends SPI communication.
+///
+void ShiftLEDSAMDBackend::end() {
+    if (descriptor == nullptr) return;
+    while (isBusy()) {}
+    dma.free();
+    descriptor = nullptr;
+    SPI_peripheral.endTransaction();
+    SPI_peripheral.end();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Points the descriptor at the frame and starts the DMA job.
+///
+void ShiftLEDSAMDBackend::startTransfer(uint8_t* data, size_t length) {
+    if (descriptor == nullptr) return;
+    dma.changeDescriptor(descriptor, data, (void*)&sercom->SPI.DATA.reg, length);
+    dma.startJob();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Returns true while a frame is still being sent.
+///
+bool ShiftLEDSAMDBackend::isBusy() {
+    if (descriptor == nullptr) return false;
+    return dma.isActive();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Returns true: the DMA engine sends the frame after startTransfer() returns.
+///
+bool ShiftLEDSAMDBackend::isAsynchronous() const {
+    return true;
+}
+#endif
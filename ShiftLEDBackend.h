@@ -0,0 +1,124 @@
+// ShiftLEDBackend.h
+
+#ifndef SHIFT_LED_BACKEND_H
+#define SHIFT_LED_BACKEND_H
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <driver/spi_master.h>
+#elif defined(ARDUINO_ARCH_RP2040)
+#include <hardware/dma.h>
+#include <hardware/spi.h>
+#elif defined(ARDUINO_ARCH_SAMD) && __has_include(<Adafruit_ZeroDMA.h>)
+#include <Adafruit_ZeroDMA.h>
+#define SHIFT_LED_HAS_SAMD_DMA
+#endif
+
+/// @brief Transport that moves an encoded frame onto the SPI bus without blocking the caller.
+class ShiftLEDBackend {
+  public:
+    virtual ~ShiftLEDBackend() {}
+
+    // Prepares the peripheral for frames of up to maxLength bytes at the given SPI clock and mode (0-3).
+    virtual void begin(uint32_t clockHz, size_t maxLength, uint8_t spiMode) = 0;
+
+    // Releases the peripheral.
+    virtual void end() = 0;
+
+    // Starts sending a frame. The buffer must stay untouched until isBusy() returns false.
+    virtual void startTransfer(uint8_t* data, size_t length) = 0;
+
+    // Returns true while a frame is still being sent.
+    virtual bool isBusy() = 0;
+
+    // Returns true if startTransfer() returns while the frame is still being sent, so the next chunk of a
+    // streamed frame can be encoded meanwhile. Blocking transports keep the default.
+    virtual bool isAsynchronous() const { return false; }
+};
+
+/// @brief Portable fallback that sends the frame with a blocking SPIClass transfer.
+class ShiftLEDSPIBackend : public ShiftLEDBackend {
+  public:
+    // Constructor
+    explicit ShiftLEDSPIBackend(SPIClass& SPI_peripheral = SPI);
+
+    void begin(uint32_t clockHz, size_t maxLength, uint8_t spiMode) override;
+    void end() override;
+    void startTransfer(uint8_t* data, size_t length) override;
+    bool isBusy() override;
+
+  private:
+    SPIClass& SPI_peripheral;
+};
+
+#if defined(ARDUINO_ARCH_ESP32)
+/// @brief ESP32 backend that queues frames on an ESP-IDF SPI master device with DMA.
+class ShiftLEDESP32Backend : public ShiftLEDBackend {
+  public:
+    // Constructor. The SPI host must not be shared with an SPIClass instance.
+    // Clocked chips (APA102) also need a clock pin.
+    explicit ShiftLEDESP32Backend(uint8_t dataPin, spi_host_device_t host = SPI2_HOST, int8_t clockPin = -1);
+
+    void begin(uint32_t clockHz, size_t maxLength, uint8_t spiMode) override;
+    void end() override;
+    void startTransfer(uint8_t* data, size_t length) override;
+    bool isBusy() override;
+    bool isAsynchronous() const override;
+
+  private:
+    uint8_t dataPin;
+    int8_t clockPin;
+    spi_host_device_t host;
+    spi_device_handle_t device;
+    spi_transaction_t transaction;
+    bool queued; // A transaction is queued and its result not yet collected
+};
+#endif
+
+#if defined(ARDUINO_ARCH_RP2040)
+/// @brief RP2040 backend that feeds the SPI TX FIFO from a DMA channel.
+class ShiftLEDRP2040Backend : public ShiftLEDBackend {
+  public:
+    // Constructor. Clocked chips (APA102) also need a clock pin.
+    explicit ShiftLEDRP2040Backend(uint8_t dataPin, spi_inst_t* spi = spi0, int8_t clockPin = -1);
+
+    void begin(uint32_t clockHz, size_t maxLength, uint8_t spiMode) override;
+    void end() override;
+    void startTransfer(uint8_t* data, size_t length) override;
+    bool isBusy() override;
+    bool isAsynchronous() const override;
+
+  private:
+    uint8_t dataPin;
+    int8_t clockPin;
+    spi_inst_t* spi;
+    int dmaChannel;
+    dma_channel_config dmaConfig;
+};
+#endif
+
+#if defined(SHIFT_LED_HAS_SAMD_DMA)
+/// @brief SAMD21/SAMD51 backend that feeds the SERCOM data register through Adafruit_ZeroDMA.
+class ShiftLEDSAMDBackend : public ShiftLEDBackend {
+  public:
+    // Constructor. dmacTrigger is the SERCOM TX trigger, e.g. SERCOM4_DMAC_ID_TX.
+    ShiftLEDSAMDBackend(SPIClass& SPI_peripheral, Sercom* sercom, uint8_t dmacTrigger);
+
+    void begin(uint32_t clockHz, size_t maxLength, uint8_t spiMode) override;
+    void end() override;
+    void startTransfer(uint8_t* data, size_t length) override;
+    bool isBusy() override;
+    bool isAsynchronous() const override;
+
+  private:
+    SPIClass& SPI_peripheral;
+    Sercom* sercom;
+    uint8_t dmacTrigger;
+    Adafruit_ZeroDMA dma;
+    DmacDescriptor* descriptor;
+};
+#endif
+
+#endif // SHIFT_LED_BACKEND_H
@@ -0,0 +1,170 @@
+// ShiftLEDColor.cpp
+
+#include "ShiftLEDColor.h"
+
+/// @brief Entry of the named color table.
+struct NamedColor {
+    char name[15];
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+};
+
+// Named colors (CSS values), kept in flash
+static const NamedColor namedColors[] PROGMEM = {
+    {"black",          0x00, 0x00, 0x00},
+    {"white",          0xFF, 0xFF, 0xFF},
+    {"red",            0xFF, 0x00, 0x00},
+    {"lime",           0x00, 0xFF, 0x00},
+    {"green",          0x00, 0x80, 0x00},
+    {"blue",           0x00, 0x00, 0xFF},
+    {"yellow",         0xFF, 0xFF, 0x00},
+    {"cyan",           0x00, 0xFF, 0xFF},
+    {"aqua",           0x00, 0xFF, 0xFF},
+    {"magenta",        0xFF, 0x00, 0xFF},
+    {"fuchsia",        0xFF, 0x00, 0xFF},
+    {"silver",         0xC0, 0xC0, 0xC0},
+    {"gray",           0x80, 0x80, 0x80},
+    {"maroon",         0x80, 0x00, 0x00},
+    {"olive",          0x80, 0x80, 0x00},
+    {"purple",         0x80, 0x00, 0x80},
+    {"teal",           0x00, 0x80, 0x80},
+    {"navy",           0x00, 0x00, 0x80},
+    {"orange",         0xFF, 0xA5, 0x00},
+    {"orangered",      0xFF, 0x45, 0x00},
+    {"gold",           0xFF, 0xD7, 0x00},
+    {"pink",           0xFF, 0xC0, 0xCB},
+    {"hotpink",        0xFF, 0x69, 0xB4},
+    {"deeppink",       0xFF, 0x14, 0x93},
+    {"violet",         0xEE, 0x82, 0xEE},
+    {"indigo",         0x4B, 0x00, 0x82},
+    {"coral",          0xFF, 0x7F, 0x50},
+    {"salmon",         0xFA, 0x80, 0x72},
+    {"tomato",         0xFF, 0x63, 0x47},
+    {"turquoise",      0x40, 0xE0, 0xD0},
+    {"skyblue",        0x87, 0xCE, 0xEB},
+    {"springgreen",    0x00, 0xFF, 0x7F},
+    {"chartreuse",     0x7F, 0xFF, 0x00},
+    {"darkolivegreen", 0x55, 0x6B, 0x2F},
+};
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Parses a color string ("#RRGGBB", "#RGB", "2700K" or a color name) without allocating.
+///
+bool parseLEDColor(const char* text, size_t length, LEDColor& color) {
+    if (length > 0 && text[0] == '#') {
+        // Hex color code
+        uint8_t digits[6];
+        size_t digitCount = length - 1;
+        if (digitCount != 6 && digitCount != 3) {
+            Serial.println("Invalid hex color format.");
+            return false;
+        }
+        for (size_t i = 0; i < digitCount; i++) {
+            digits[i] = hexDigitValue(text[i + 1]);
+            if (digits[i] > 0x0F) {
+                Serial.println("Invalid hex color format.");
+                return false;
+            }
+        }
+
+        if (digitCount == 6) { // Format: #RRGGBB
+            color = LEDColor(digits[0] * 16 + digits[1], digits[2] * 16 + digits[3], digits[4] * 16 + digits[5]);
+        } else {               // Format: #RGB
+            color = LEDColor(digits[0] * 17, digits[1] * 17, digits[2] * 17); // Duplicate hex digit
+        }
+        return true;
+    }
+
+    if (length > 1 && (text[length - 1] == 'K' || text[length - 1] == 'k')) {
+        // Kelvin temperature, unless it is a name ending in 'k' such as "pink"
+        uint32_t kelvin = 0;
+        size_t i = 0;
+        for (; i < length - 1 && text[i] >= '0' && text[i] <= '9'; i++) {
+            if (kelvin < 100000) kelvin = kelvin * 10 + (text[i] - '0');
+        }
+        if (i == length - 1) {
+            color = kelvinToColor(kelvin);
+            return true;
+        }
+    }
+
+    if (findNamedColor(text, length, color)) {
+        return true;
+    }
+
+    Serial.println("Unknown color format.");
+    return false;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Looks up a color name (case-insensitive) in the flash-resident named color table.
+///
+bool findNamedColor(const char* name, size_t length, LEDColor& color) {
+    if (length >= sizeof(NamedColor::name)) return false;
+
+    for (size_t i = 0; i < sizeof(namedColors) / sizeof(namedColors[0]); i++) {
+        NamedColor entry;
+        memcpy_P(&entry, &namedColors[i], sizeof(entry));
+
+        if (strlen(entry.name) == length && strncasecmp(entry.name, name, length) == 0) {
+            color = LEDColor(entry.red, entry.green, entry.blue);
+            return true;
+        }
+    }
+    return false;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Reports a malformed _rgb literal evaluated at run time; constant expressions reject it at compile time.
+///
+uint8_t ShiftLEDLiterals::invalidColorLiteral() {
+    Serial.println("Invalid color literal.");
+    return 0;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Multiplies a value by scale/255, exact at both ends, with a multiply and a shift.
+///
+static inline uint8_t scale8(uint8_t value, uint8_t scale) {
+    return ((uint16_t)value * (scale + 1)) >> 8;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Builds a color from a hue and the lowest and highest component levels.
+///
+static LEDColor hueToColor(uint8_t hue, uint8_t minimum, uint8_t chroma) {
+    // Six sectors of the color wheel, each with a fraction that ramps one component up or down
+    uint16_t position = hue * 6;
+    uint8_t fraction = position & 0xFF;
+    uint8_t high = minimum + chroma;
+    uint8_t rising = minimum + scale8(chroma, fraction);
+    uint8_t falling = minimum + scale8(chroma, 255 - fraction);
+
+    switch (position >> 8) {
+        case 0:  return LEDColor(high, rising, minimum);
+        case 1:  return LEDColor(falling, high, minimum);
+        case 2:  return LEDColor(minimum, high, rising);
+        case 3:  return LEDColor(minimum, falling, high);
+        case 4:  return LEDColor(rising, minimum, high);
+        default: return LEDColor(high, minimum, falling);
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Converts hue, saturation and value to a color with integer math.
+///
+LEDColor hsvToColor(uint8_t hue, uint8_t saturation, uint8_t value) {
+    uint8_t chroma = scale8(value, saturation);
+    return hueToColor(hue, value - chroma, chroma);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Converts hue, saturation and lightness to a color with integer math.
+///
+LEDColor hslToColor(uint8_t hue, uint8_t saturation, uint8_t lightness) {
+    // Chroma peaks at mid lightness and is centered on it, so the levels stay within 0-255
+    uint8_t range = (lightness < 128) ? lightness * 2 : (lightness == 128) ? 255 : (255 - lightness) * 2;
+    uint8_t chroma = scale8(range, saturation);
+    return hueToColor(hue, lightness - (chroma + 1) / 2, chroma);
+}
@@ -0,0 +1,77 @@
+// ShiftLEDColor.h
+
+#ifndef SHIFT_LED_COLOR_H
+#define SHIFT_LED_COLOR_H
+
+#include <Arduino.h>
+
+/// @brief Color value with all supported components.
+struct LEDColor {
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint8_t white;
+    uint8_t warmWhite;
+    uint8_t coldWhite;
+
+    explicit constexpr LEDColor(uint8_t red = 0, uint8_t green = 0, uint8_t blue = 0,
+                                uint8_t white = 0, uint8_t warmWhite = 0, uint8_t coldWhite = 0)
+        : red(red), green(green), blue(blue), white(white), warmWhite(warmWhite), coldWhite(coldWhite) {}
+};
+
+// Converts a hex digit to its value, or 0xFF if the character is not a hex digit.
+constexpr uint8_t hexDigitValue(char c) {
+    return (c >= '0' && c <= '9') ? c - '0' :
+           (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+           (c >= 'A' && c <= 'F') ? c - 'A' + 10 : 0xFF;
+}
+
+// Converts a Kelvin temperature (clamped to 2000-9000 K) to warm and cold white components.
+constexpr LEDColor kelvinToColor(uint32_t kelvin) {
+    return (kelvin < 2000) ? kelvinToColor(2000) :
+           (kelvin > 9000) ? kelvinToColor(9000) :
+           LEDColor(0, 0, 0, 0, (9000 - kelvin) * 255 / 7000, (kelvin - 2000) * 255 / 7000);
+}
+
+// Converts hue, saturation and value (0-255 each; hue 256 is a full turn) to a color with integer math.
+LEDColor hsvToColor(uint8_t hue, uint8_t saturation, uint8_t value);
+
+// Converts hue, saturation and lightness (0-255 each; lightness 128 is the pure hue) to a color with integer math.
+LEDColor hslToColor(uint8_t hue, uint8_t saturation, uint8_t lightness);
+
+// Parses a color string ("#RRGGBB", "#RGB", "2700K" or a color name) without allocating.
+bool parseLEDColor(const char* text, size_t length, LEDColor& color);
+
+// Looks up a color name (case-insensitive) in the flash-resident named color table.
+bool findNamedColor(const char* name, size_t length, LEDColor& color);
+
+/// @brief Compile-time color literals: "#FF5733"_rgb, "#F53"_rgb and 2700_K.
+namespace ShiftLEDLiterals {
+    // Reached only by a malformed _rgb literal. It is not constexpr, so such a literal in a constant expression
+    // fails to compile; evaluated at run time it reports the error and yields 0.
+    uint8_t invalidColorLiteral();
+
+    // Converts two hex digits to a byte.
+    constexpr uint8_t hexByte(char high, char low) {
+        return (hexDigitValue(high) > 0x0F || hexDigitValue(low) > 0x0F) ? invalidColorLiteral() :
+               hexDigitValue(high) * 16 + hexDigitValue(low);
+    }
+
+    // "#RRGGBB" or "#RGB"; anything else is rejected (at compile time in a constant expression).
+    constexpr LEDColor operator""_rgb(const char* text, size_t length) {
+        return (length == 7 && text[0] == '#') ? LEDColor(hexByte(text[1], text[2]),
+                                                          hexByte(text[3], text[4]),
+                                                          hexByte(text[5], text[6])) :
+               (length == 4 && text[0] == '#') ? LEDColor(hexByte(text[1], text[1]),
+                                                          hexByte(text[2], text[2]),
+                                                          hexByte(text[3], text[3])) :
+               LEDColor(invalidColorLiteral());
+    }
+
+    // Color temperature in Kelvin, mapped to warm and cold white.
+    constexpr LEDColor operator""_K(unsigned long long kelvin) {
+        return kelvinToColor(kelvin > 9000 ? 9000 : (uint32_t)kelvin);
+    }
+}
+
+#endif // SHIFT_LED_COLOR_H
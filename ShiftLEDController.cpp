@@ -0,0 +1,257 @@
+// ShiftLEDController.cpp
+
+#include "ShiftLEDController.h"
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Constructor for ShiftLEDController class.
+///
+ShiftLEDController::ShiftLEDController()
+    : outputCount(0), desiredGlobalBrightness(255), actualGlobalBrightness(255), maxAllowedPower_mW(0) {}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Appends an output; its LEDs follow those of the previously added output.
+///
+bool ShiftLEDController::addOutput(ShiftLED& output) {
+    if (outputCount >= MAX_OUTPUTS) {
+        Serial.println("Too many outputs.");
+        return false;
+    }
+
+    // The controller owns the power budget; outputs only apply the brightness it hands them
+    output.setMaxPower(0);
+    outputs[outputCount++] = &output;
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the number of outputs.
+///
+uint8_t ShiftLEDController::getOutputCount() const {
+    return outputCount;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets an output by position.
+///
+ShiftLED& ShiftLEDController::getOutput(uint8_t position) {
+    return *outputs[position];
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Initializes all outputs.
+///
+void ShiftLEDController::begin() {
+    for (uint8_t i = 0; i < outputCount; i++) {
+        outputs[i]->begin();
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Ends all outputs.
+///
+void ShiftLEDController::end() {
+    for (uint8_t i = 0; i < outputCount; i++) {
+        outputs[i]->end();
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Finds the output holding a logical index and converts the index to a local one.
+///
+ShiftLED* ShiftLEDController::locate(uint32_t& index) const {
+    for (uint8_t i = 0; i < outputCount; i++) {
+        uint32_t outputLEDs = outputs[i]->getNumLEDs();
+        if (index < outputLEDs) return outputs[i];
+        index -= outputLEDs;
+    }
+    return nullptr;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of a single LED using color components.
+///
+void ShiftLEDController::setLEDColor(uint32_t index, uint8_t red, uint8_t green, uint8_t blue,
+                                     uint8_t white, uint8_t warmWhite, uint8_t coldWhite,
+                                     uint8_t brightness) {
+    ShiftLED* output = locate(index);
+    if (output == nullptr) return;
+    output->setLEDColor(index, red, green, blue, white, warmWhite, coldWhite, brightness);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of a single LED using a color value.
+///
+void ShiftLEDController::setLEDColor(uint32_t index, const LEDColor& color, uint8_t brightness) {
+    ShiftLED* output = locate(index);
+    if (output == nullptr) return;
+    output->setLEDColor(index, color, brightness);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of all LEDs using a color value.
+///
+void ShiftLEDController::setAllLEDs(const LEDColor& color, uint8_t brightness) {
+    for (uint8_t i = 0; i < outputCount; i++) {
+        outputs[i]->setAllLEDs(color, brightness);
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the color of count LEDs starting at start, split across the outputs it spans.
+///
+void ShiftLEDController::fillRange(uint32_t start, uint32_t count, const LEDColor& color, uint8_t brightness) {
+    for (uint8_t i = 0; i < outputCount && count > 0; i++) {
+        uint32_t outputLEDs = outputs[i]->getNumLEDs();
+        if (start >= outputLEDs) {
+            start -= outputLEDs;
+            continue;
+        }
+
+        uint32_t segment = (count < outputLEDs - start) ? count : outputLEDs - start;
+        outputs[i]->fillRange(start, segment, color, brightness);
+        count -= segment;
+        start = 0;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Copies count packed pixels into the strip starting at start, split across the outputs it spans.
+///
+void ShiftLEDController::setPixels(uint32_t start, const uint8_t* pixels, uint32_t count, PixelFormat format,
+                                   uint8_t brightness) {
+    for (uint8_t i = 0; i < outputCount && count > 0; i++) {
+        uint32_t outputLEDs = outputs[i]->getNumLEDs();
+        if (start >= outputLEDs) {
+            start -= outputLEDs;
+            continue;
+        }
+
+        // Native data has the stride of the output it is written to
+        uint8_t stride = (format == PIXEL_FORMAT_RGB) ? 3 :
+                         (format == PIXEL_FORMAT_RGBW) ? 4 : outputs[i]->getColorComponentCount();
+        uint32_t segment = (count < outputLEDs - start) ? count : outputLEDs - start;
+        outputs[i]->setPixels(start, pixels, segment, format, brightness);
+        pixels += (size_t)segment * stride;
+        count -= segment;
+        start = 0;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the desired global brightness level of all outputs.
+///
+void ShiftLEDController::setGlobalBrightness(uint8_t brightnessLevel) {
+    desiredGlobalBrightness = brightnessLevel;
+    updateActualBrightness();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the maximum power consumption shared by all outputs.
+///
+void ShiftLEDController::setMaxPower(uint32_t maxPower_mW) {
+    maxAllowedPower_mW = maxPower_mW;
+    updateActualBrightness();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the maximum power consumption per LED at full brightness on all outputs.
+///
+void ShiftLEDController::setMaxPowerPerLED(uint16_t maxPowerPerLED_mW) {
+    for (uint8_t i = 0; i < outputCount; i++) {
+        outputs[i]->setMaxPowerPerLED(maxPowerPerLED_mW);
+    }
+    updateActualBrightness();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Applies the shared power budget to the global brightness of all outputs.
+///
+void ShiftLEDController::updateActualBrightness() {
+    actualGlobalBrightness = desiredGlobalBrightness;
+
+    if (maxAllowedPower_mW != 0) {
+        // Estimate the total power consumption at desired brightness
+        uint32_t estimatedPower = estimateDesiredPowerConsumption();
+        if (estimatedPower > maxAllowedPower_mW) {
+            // Reduce actual global brightness proportionally on every output
+            actualGlobalBrightness = (uint32_t)desiredGlobalBrightness * maxAllowedPower_mW / estimatedPower;
+        }
+    }
+
+    for (uint8_t i = 0; i < outputCount; i++) {
+        outputs[i]->setGlobalBrightness(actualGlobalBrightness);
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Encodes and sends all outputs, then waits until every output is done.
+///
+void ShiftLEDController::update() {
+    updateAsync();
+    while (isBusy()) {}
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Encodes and starts all outputs without waiting for completion.
+///
+void ShiftLEDController::updateAsync() {
+    updateActualBrightness();
+
+    // Each output is encoded while the previously started ones are already on their buses
+    for (uint8_t i = 0; i < outputCount; i++) {
+        outputs[i]->updateAsync();
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Returns true while any output is still sending.
+///
+bool ShiftLEDController::isBusy() {
+    bool busy = false;
+    for (uint8_t i = 0; i < outputCount; i++) {
+        // Poll every output so each one records its completion
+        if (outputs[i]->isBusy()) busy = true;
+    }
+    return busy;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the total number of LEDs.
+///
+uint32_t ShiftLEDController::getNumLEDs() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < outputCount; i++) {
+        total += outputs[i]->getNumLEDs();
+    }
+    return total;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the actual global brightness level after power limiting.
+///
+uint8_t ShiftLEDController::getActualGlobalBrightness() const {
+    return actualGlobalBrightness;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Estimates the total power consumption after brightness adjustment.
+///
+uint32_t ShiftLEDController::estimatePowerConsumption() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < outputCount; i++) {
+        total += outputs[i]->estimatePowerConsumption();
+    }
+    return total;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Estimates the total power consumption before brightness adjustment.
+///
+uint32_t ShiftLEDController::estimateDesiredPowerConsumption() const {
+    // Outputs run at the actual brightness, so ask for their consumption at the desired one
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < outputCount; i++) {
+        total += outputs[i]->estimatePowerConsumption(desiredGlobalBrightness);
+    }
+    return total;
+}
@@ -0,0 +1,97 @@
+// ShiftLEDController.h
+
+#ifndef SHIFT_LED_CONTROLLER_H
+#define SHIFT_LED_CONTROLLER_H
+
+#include "ShiftLED.h"
+
+/// @brief Drives several ShiftLED outputs as one logical strip with a shared power budget.
+///
+/// Outputs are mapped onto consecutive index ranges in the order they are added. Each output keeps its
+/// own color order and SPI peripheral; with DMA backends all outputs transmit in parallel.
+class ShiftLEDController {
+  public:
+    // Maximum number of outputs.
+    static const uint8_t MAX_OUTPUTS = 8;
+
+    // Constructor
+    ShiftLEDController();
+
+    // Appends an output; its LEDs follow those of the previously added output.
+    bool addOutput(ShiftLED& output);
+
+    // Gets the number of outputs.
+    uint8_t getOutputCount() const;
+
+    // Gets an output by position.
+    ShiftLED& getOutput(uint8_t position);
+
+    // Initializes all outputs.
+    void begin();
+
+    // Ends all outputs.
+    void end();
+
+    // Sets the color of a single LED using color components.
+    void setLEDColor(uint32_t index, uint8_t red, uint8_t green, uint8_t blue,
+                     uint8_t white = 0, uint8_t warmWhite = 0, uint8_t coldWhite = 0,
+                     uint8_t brightness = 255);
+
+    // Sets the color of a single LED using a color value.
+    void setLEDColor(uint32_t index, const LEDColor& color, uint8_t brightness = 255);
+
+    // Sets the color of all LEDs using a color value.
+    void setAllLEDs(const LEDColor& color, uint8_t brightness = 255);
+
+    // Sets the color of count LEDs starting at start.
+    void fillRange(uint32_t start, uint32_t count, const LEDColor& color, uint8_t brightness = 255);
+
+    // Copies count packed pixels into the strip starting at start.
+    void setPixels(uint32_t start, const uint8_t* pixels, uint32_t count,
+                   PixelFormat format = PIXEL_FORMAT_RGB, uint8_t brightness = 255);
+
+    // Sets the desired global brightness level (0-255) of all outputs.
+    void setGlobalBrightness(uint8_t brightnessLevel);
+
+    // Sets the maximum power consumption in milliwatts (mW) shared by all outputs (0 = unlimited).
+    void setMaxPower(uint32_t maxPower_mW);
+
+    // Sets the maximum power consumption per LED at full brightness on all outputs.
+    void setMaxPowerPerLED(uint16_t maxPowerPerLED_mW);
+
+    // Encodes and sends all outputs, then waits until every output is done.
+    void update();
+
+    // Encodes and starts all outputs without waiting for completion.
+    void updateAsync();
+
+    // Returns true while any output is still sending.
+    bool isBusy();
+
+    // Gets the total number of LEDs.
+    uint32_t getNumLEDs() const;
+
+    // Gets the actual global brightness level after power limiting.
+    uint8_t getActualGlobalBrightness() const;
+
+    // Estimates the total power consumption in milliwatts (mW) after brightness adjustment.
+    uint32_t estimatePowerConsumption() const;
+
+    // Estimates the total power consumption in milliwatts (mW) before brightness adjustment.
+    uint32_t estimateDesiredPowerConsumption() const;
+
+  private:
+    ShiftLED* outputs[MAX_OUTPUTS];
+    uint8_t outputCount;
+    uint8_t desiredGlobalBrightness; // Desired global brightness (0-255)
+    uint8_t actualGlobalBrightness;  // Actual global brightness (0-255)
+    uint32_t maxAllowedPower_mW;     // Shared power budget (0 = unlimited)
+
+    // Finds the output holding a logical index and converts the index to a local one.
+    ShiftLED* locate(uint32_t& index) const;
+
+    // Applies the shared power budget to the global brightness of all outputs.
+    void updateActualBrightness();
+};
+
+#endif // SHIFT_LED_CONTROLLER_H
@@ -0,0 +1,114 @@
+// ShiftLEDFixed.h
+
+#ifndef SHIFT_LED_FIXED_H
+#define SHIFT_LED_FIXED_H
+
+#include "ShiftLED.h"
+
+/// @brief Color component order known at compile time.
+template <ColorComponent... Components>
+struct ColorOrderList {
+    static_assert(sizeof...(Components) > 0, "A color order needs at least one component.");
+
+    // Number of color components per LED.
+    static constexpr uint8_t count = sizeof...(Components);
+
+    // Component order on the wire.
+    static constexpr ColorComponent components[sizeof...(Components)] = {Components...};
+
+    // Selects the value of one component at compile time.
+    template <ColorComponent Component>
+    static uint8_t select(uint8_t red, uint8_t green, uint8_t blue,
+                          uint8_t white, uint8_t warmWhite, uint8_t coldWhite) {
+        return Component == RED        ? red :
+               Component == GREEN      ? green :
+               Component == BLUE       ? blue :
+               Component == WHITE      ? white :
+               Component == WARM_WHITE ? warmWhite :
+               Component == COLD_WHITE ? coldWhite : 0;
+    }
+
+    // Stores the components of one LED in wire order.
+    static void store(uint8_t* p, uint8_t red, uint8_t green, uint8_t blue,
+                      uint8_t white, uint8_t warmWhite, uint8_t coldWhite) {
+        uint8_t i = 0;
+        int expand[] = {(p[i++] = select<Components>(red, green, blue, white, warmWhite, coldWhite), 0)...};
+        (void)expand;
+    }
+
+    // Sums the active (non-NONE) components of one LED.
+    static uint16_t colorSum(const uint8_t* p) {
+        uint16_t sum = 0;
+        uint8_t i = 0;
+        int expand[] = {(sum += (Components != NONE) ? p[i] : 0, i++, 0)...};
+        (void)expand;
+        return sum;
+    }
+};
+
+template <ColorComponent... Components>
+constexpr ColorComponent ColorOrderList<Components...>::components[sizeof...(Components)];
+
+/// @brief Common color orders for ShiftLEDFixed.
+namespace ShiftLEDOrder {
+    typedef ColorOrderList<RED, GREEN, BLUE> RGB;
+    typedef ColorOrderList<RED, BLUE, GREEN> RBG;
+    typedef ColorOrderList<GREEN, RED, BLUE> GRB;
+    typedef ColorOrderList<GREEN, BLUE, RED> GBR;
+    typedef ColorOrderList<BLUE, RED, GREEN> BRG;
+    typedef ColorOrderList<BLUE, GREEN, RED> BGR;
+    typedef ColorOrderList<RED, GREEN, BLUE, WHITE> RGBW;
+    typedef ColorOrderList<GREEN, RED, BLUE, WHITE> GRBW;
+    typedef ColorOrderList<RED, GREEN, BLUE, COLD_WHITE, WARM_WHITE> RGBCH;
+
+    typedef GRB WS2812;
+    typedef GRB SK6812;
+}
+
+/// @brief ShiftLED variant whose color order is a compile-time constant.
+///
+/// Pixel stores, power accounting and frame encoding compile to straight-line code for the given order.
+/// Use ShiftLED with a type string when the order is only known at runtime.
+template <typename Order>
+class ShiftLEDFixed : public ShiftLED {
+  public:
+    // Constructor
+    ShiftLEDFixed(uint32_t numLEDs, uint8_t dataPin, SPIClass& SPI_peripheral = SPI)
+        : ShiftLED(Order::components, Order::count, numLEDs, dataPin, SPI_peripheral) {}
+
+    // Constructor for caller-provided (e.g. static) buffers.
+    ShiftLEDFixed(uint32_t numLEDs, uint8_t dataPin, const ShiftLEDBuffers& buffers, SPIClass& SPI_peripheral = SPI)
+        : ShiftLED(Order::components, Order::count, numLEDs, dataPin, SPI_peripheral, &buffers) {}
+
+    using ShiftLED::setLEDColor;
+
+    // Sets the color of a single LED using color components.
+    void setLEDColor(uint32_t index, uint8_t red, uint8_t green, uint8_t blue,
+                     uint8_t white = 0, uint8_t warmWhite = 0, uint8_t coldWhite = 0,
+                     uint8_t brightness = 255) {
+        if (index >= this->numLEDs) return;
+        if (storage != PIXEL_STORAGE_DIRECT) {
+            // Palette lookups are not worth specializing
+            ShiftLED::setLEDColor(index, red, green, blue, white, warmWhite, coldWhite, brightness);
+            return;
+        }
+
+        uint8_t* p = &this->ledData[index * Order::count];
+        powerWeightSum -= (uint32_t)getLEDBrightness(index) * Order::colorSum(p);
+
+        // Store colors in wire order
+        Order::store(p, red, green, blue, white, warmWhite, coldWhite);
+        storeBrightness(index, 1, brightness);
+        markDirty(index);
+
+        powerWeightSum += (uint32_t)getLEDBrightness(index) * Order::colorSum(p);
+    }
+
+  protected:
+    // Encodes count pixels from start with the component count as a constant.
+    void encodeFrame(uint8_t* out, uint32_t start, uint32_t count) override {
+        encodeFrameAs<Order::count>(out, start, count);
+    }
+};
+
+#endif // SHIFT_LED_FIXED_H
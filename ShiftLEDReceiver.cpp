@@ -0,0 +1,371 @@
+// ShiftLEDReceiver.cpp
+
+#include "ShiftLEDReceiver.h"
+
+static const uint8_t TPM2_START = 0xC9;
+static const uint8_t TPM2_DATA_FRAME = 0xDA;
+static const uint8_t TPM2_END = 0x36;
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Constructor for ShiftLEDReceiver class.
+///
+ShiftLEDReceiver::ShiftLEDReceiver(ShiftLED& leds, Stream& stream, ReceiverProtocol protocol)
+    : leds(leds), stream(stream), protocol(protocol), state(STATE_IDLE), timeout_ms(100), lastByte_ms(0),
+      inputStride(0), directCopy(false), headerHigh(0), headerLow(0), tpm2Frame(false), skipPayload(false),
+      payloadLength(0), payloadPosition(0), staging(nullptr), stagingSize(0), staged(false), target(nullptr),
+      targetLength(0), pixelsStored(0), scratchFill(0), frameCount(0), droppedFrames(0), corruptFrames(0) {
+    buffer = leds.getPixelBuffer();
+    setInputOrder("RGB");
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Destructor for ShiftLEDReceiver class.
+///
+ShiftLEDReceiver::~ShiftLEDReceiver() {
+    delete[] staging;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Announces the receiver to Adalight hosts and allocates the TPM2 staging buffer.
+///
+void ShiftLEDReceiver::begin() {
+    // Sized once for the strip's capacity and never reallocated; the strip cannot grow past it after its begin()
+    if (protocol != RECEIVER_PROTOCOL_ADALIGHT && staging == nullptr) {
+        size_t size = (size_t)leds.getCapacity() * leds.getColorComponentCount();
+        staging = new uint8_t[size];
+        if (staging == nullptr) {
+            Serial.println("Not enough memory to stage TPM2 frames; they are written to the strip directly.");
+        } else {
+            stagingSize = size;
+        }
+    }
+    if (protocol != RECEIVER_PROTOCOL_TPM2) {
+        stream.print("Ada\n");
+    }
+    lastByte_ms = millis();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets the component order of the incoming pixels.
+///
+bool ShiftLEDReceiver::setInputOrder(const char* order) {
+    size_t length = (order != nullptr) ? strlen(order) : 0;
+    if (length == 0 || length > MAX_INPUT_COMPONENTS) {
+        Serial.println("Invalid input order.");
+        return false;
+    }
+
+    ColorComponent components[MAX_INPUT_COMPONENTS];
+    for (size_t i = 0; i < length; i++) {
+        switch (toupper(order[i])) {
+            case 'R': components[i] = RED; break;
+            case 'G': components[i] = GREEN; break;
+            case 'B': components[i] = BLUE; break;
+            case 'W': components[i] = WHITE; break;
+            case 'C': components[i] = COLD_WHITE; break;
+            case 'H': components[i] = WARM_WHITE; break;
+            case 'N': components[i] = NONE; break;
+            default:
+                Serial.println("Invalid input order.");
+                return false;
+        }
+    }
+
+    memcpy(inputOrder, components, length * sizeof(ColorComponent));
+    inputStride = length;
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sets how long a frame may stall between two bytes before it is dropped.
+///
+void ShiftLEDReceiver::setTimeout(uint16_t timeout_ms) {
+    this->timeout_ms = timeout_ms;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Parses the available bytes; returns true if a frame was completed and sent.
+///
+bool ShiftLEDReceiver::run() {
+    int available = stream.available();
+    if (available <= 0) {
+        // A frame that stalls is abandoned so the next header can resynchronize the stream
+        if (state != STATE_IDLE && (uint32_t)(millis() - lastByte_ms) >= timeout_ms) {
+            droppedFrames++;
+            abandonFrame();
+        }
+        return false;
+    }
+    lastByte_ms = millis();
+
+    // Stop at the end of a frame so the next one cannot overwrite it before it has been sent
+    while (available > 0) {
+        if (state == STATE_PAYLOAD) {
+            size_t length = readPayload(available);
+            if (length == 0) break;
+            available -= length;
+            if (payloadPosition < payloadLength) continue;
+
+            if (tpm2Frame) {
+                state = STATE_TPM2_END;
+                continue;
+            }
+            state = STATE_IDLE;
+            showFrame();
+            return true;
+        }
+
+        int value = stream.read();
+        if (value < 0) break;
+        available--;
+        if (parseByte(value)) {
+            showFrame();
+            return true;
+        }
+    }
+    return false;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Advances the framing by one byte outside the payload; returns true if a frame is complete.
+///
+bool ShiftLEDReceiver::parseByte(uint8_t value) {
+    switch (state) {
+        case STATE_IDLE:
+            // Anything else between frames is noise, e.g. a partial frame sent before a reset
+            if (value == 'A' && protocol != RECEIVER_PROTOCOL_TPM2) {
+                state = STATE_ADA_D;
+            } else if (value == TPM2_START && protocol != RECEIVER_PROTOCOL_ADALIGHT) {
+                state = STATE_TPM2_TYPE;
+            }
+            return false;
+
+        case STATE_ADA_D:
+        case STATE_ADA_A: {
+            char expected = (state == STATE_ADA_D) ? 'd' : 'a';
+            if (value != expected) {
+                // The byte may start the real header
+                state = STATE_IDLE;
+                return parseByte(value);
+            }
+            state = (state == STATE_ADA_D) ? STATE_ADA_A : STATE_ADA_HIGH;
+            return false;
+        }
+
+        case STATE_ADA_HIGH:
+            headerHigh = value;
+            state = STATE_ADA_LOW;
+            return false;
+
+        case STATE_ADA_LOW:
+            headerLow = value;
+            state = STATE_ADA_CHECKSUM;
+            return false;
+
+        case STATE_ADA_CHECKSUM:
+            if (value != (headerHigh ^ headerLow ^ 0x55)) {
+                corruptFrames++;
+                state = STATE_IDLE;
+                return false;
+            }
+            // The header holds the LED count minus one
+            tpm2Frame = false;
+            skipPayload = false;
+            startPayload(((uint32_t)((headerHigh << 8) | headerLow) + 1) * inputStride);
+            return false;
+
+        case STATE_TPM2_TYPE:
+            // Command and response packets are framed the same way and skipped
+            tpm2Frame = true;
+            skipPayload = (value != TPM2_DATA_FRAME);
+            state = STATE_TPM2_SIZE_HIGH;
+            return false;
+
+        case STATE_TPM2_SIZE_HIGH:
+            headerHigh = value;
+            state = STATE_TPM2_SIZE_LOW;
+            return false;
+
+        case STATE_TPM2_SIZE_LOW:
+            startPayload((headerHigh << 8) | value);
+            if (payloadLength == 0) state = STATE_TPM2_END;
+            return false;
+
+        case STATE_TPM2_END:
+            if (value != TPM2_END) {
+                corruptFrames++;
+                abandonFrame();
+                return false;
+            }
+            state = STATE_IDLE;
+            return !skipPayload;
+
+        case STATE_PAYLOAD:
+        default:
+            return false;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Prepares for a payload of the given length.
+///
+void ShiftLEDReceiver::startPayload(uint32_t length) {
+    payloadLength = length;
+    payloadPosition = 0;
+    pixelsStored = 0;
+    scratchFill = 0;
+    state = STATE_PAYLOAD;
+
+    // The strip may have been resized since the last frame. TPM2 data is staged in the strip's native layout
+    buffer = leds.getPixelBuffer();
+    uint8_t componentCount = leds.getColorComponentCount();
+    staged = tpm2Frame && !skipPayload && staging != nullptr;
+    target = staged ? staging : buffer.data;
+    targetLength = buffer.length;
+    if (staged && targetLength > stagingSize / componentCount) targetLength = stagingSize / componentCount;
+    directCopy = (staged || leds.getPixelStorage() == PIXEL_STORAGE_DIRECT) && inputStride == componentCount;
+    for (uint8_t c = 0; c < componentCount; c++) {
+        ColorComponent component = leds.getColorComponent(c);
+        sourceOffset[c] = -1;
+        for (uint8_t k = 0; k < inputStride && component != NONE; k++) {
+            if (inputOrder[k] == component) {
+                sourceOffset[c] = k;
+                break;
+            }
+        }
+        if (sourceOffset[c] != c) directCopy = false;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Reads up to available payload bytes into the strip or staging; returns the number read.
+///
+size_t ShiftLEDReceiver::readPayload(size_t available) {
+    size_t length = payloadLength - payloadPosition;
+    if (length > available) length = available;
+
+    uint32_t stripBytes = targetLength * inputStride;
+    if (directCopy && !skipPayload && payloadPosition < stripBytes) {
+        // Same layout as the strip: the bytes go straight into the pixel buffer (or staging)
+        if (length > stripBytes - payloadPosition) length = stripBytes - payloadPosition;
+        length = stream.readBytes(target + payloadPosition, length);
+    } else {
+        if (length > (size_t)(SCRATCH_SIZE - scratchFill)) length = SCRATCH_SIZE - scratchFill;
+        length = stream.readBytes(scratch + scratchFill, length);
+        scratchFill += length;
+        if (directCopy || skipPayload || pixelsStored >= targetLength) {
+            scratchFill = 0; // Pixels past the end of the strip are discarded
+        } else {
+            storeScratch();
+        }
+    }
+
+    payloadPosition += length;
+    return length;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Reorders the complete pixels in scratch into the strip or staging.
+///
+void ShiftLEDReceiver::storeScratch() {
+    uint8_t pixels = scratchFill / inputStride;
+    uint32_t count = targetLength - pixelsStored;
+    if (count > pixels) count = pixels;
+
+    uint8_t componentCount = leds.getColorComponentCount();
+    const uint8_t* source = scratch;
+    if (staged || leds.getPixelStorage() == PIXEL_STORAGE_DIRECT) {
+        uint8_t* pixel = target + (size_t)pixelsStored * componentCount;
+        for (uint32_t i = 0; i < count; i++) {
+            for (uint8_t c = 0; c < componentCount; c++) {
+                pixel[c] = (sourceOffset[c] >= 0) ? source[sourceOffset[c]] : 0;
+            }
+            pixel += componentCount;
+            source += inputStride;
+        }
+    } else {
+        // Palette storage maps each color to an entry
+        uint8_t color[MAX_INPUT_COMPONENTS];
+        for (uint32_t i = 0; i < count; i++) {
+            for (uint8_t c = 0; c < componentCount; c++) {
+                color[c] = (sourceOffset[c] >= 0) ? source[sourceOffset[c]] : 0;
+            }
+            leds.setPixels(pixelsStored + i, color, 1, PIXEL_FORMAT_NATIVE);
+            source += inputStride;
+        }
+    }
+    pixelsStored += count;
+
+    // Keep the bytes of an incomplete pixel for the next read
+    uint8_t used = pixels * inputStride;
+    scratchFill -= used;
+    memmove(scratch, scratch + used, scratchFill);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the number of strip LEDs the current payload has written.
+///
+uint32_t ShiftLEDReceiver::getPixelsWritten() const {
+    if (skipPayload) return 0;
+    if (!directCopy) return pixelsStored;
+
+    // A staged partial pixel is left behind; one written to the strip has changed it
+    uint32_t stripBytes = targetLength * inputStride;
+    uint32_t written = (payloadPosition < stripBytes) ? payloadPosition : stripBytes;
+    return staged ? written / inputStride : (written + inputStride - 1) / inputStride;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Copies a staged frame to the strip, then publishes and sends the frame.
+///
+void ShiftLEDReceiver::showFrame() {
+    uint32_t count = getPixelsWritten();
+    if (!staged) {
+        leds.markPixelsChanged(0, count);
+    } else if (leds.getPixelStorage() == PIXEL_STORAGE_DIRECT) {
+        PixelBuffer pixels = leds.getPixelBuffer();
+        if (count > pixels.length) count = pixels.length;
+        memcpy(pixels.data, staging, (size_t)count * leds.getColorComponentCount());
+        leds.markPixelsChanged(0, count);
+    } else if (count > 0) {
+        // Palette storage maps each color to an entry
+        leds.setPixels(0, staging, count, PIXEL_FORMAT_NATIVE);
+    }
+
+    // In pipeline mode the frame goes to the output side first; without a backend updateAsync() blocks
+    leds.publish();
+    leds.updateAsync();
+    frameCount++;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gives up on the current frame without sending it.
+///
+void ShiftLEDReceiver::abandonFrame() {
+    // Pixels written to the strip no longer match its power sums; the next frame rewrites them
+    if (!staged && (state == STATE_PAYLOAD || state == STATE_TPM2_END)) {
+        leds.markPixelsChanged(0, getPixelsWritten());
+    }
+    state = STATE_IDLE;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the number of frames sent.
+///
+uint32_t ShiftLEDReceiver::getFrameCount() const {
+    return frameCount;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the number of frames abandoned because the stream stalled mid-frame.
+///
+uint32_t ShiftLEDReceiver::getDroppedFrames() const {
+    return droppedFrames;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the number of frames rejected for a bad checksum or end byte.
+///
+uint32_t ShiftLEDReceiver::getCorruptFrames() const {
+    return corruptFrames;
+}
@@ -0,0 +1,129 @@
+// ShiftLEDReceiver.h
+
+#ifndef SHIFT_LED_RECEIVER_H
+#define SHIFT_LED_RECEIVER_H
+
+#include "ShiftLED.h"
+
+/// @brief Framing protocols accepted by ShiftLEDReceiver.
+enum ReceiverProtocol {
+    RECEIVER_PROTOCOL_AUTO,      // Accepts both; each frame is recognized by its first byte
+    RECEIVER_PROTOCOL_ADALIGHT,  // 'A' 'd' 'a' count-1 (16-bit) checksum, then the pixel data
+    RECEIVER_PROTOCOL_TPM2       // 0xC9 type size (16-bit), then the payload and 0x36
+};
+
+/// @brief Receives frames streamed by PC software (Adalight, TPM2) and shows them on a strip.
+///
+/// Call run() from loop(). Frames are parsed incrementally from whatever bytes have arrived and written straight
+/// into the strip's pixel buffer; the strip is updated once a frame is complete. An Adalight frame that stalls is
+/// not sent, and the next one rewrites its pixels. TPM2 frames are only known to be good at their end byte, so
+/// they are staged in a buffer allocated by begin() and copied to the strip once complete. Per-LED brightness is
+/// left as is.
+class ShiftLEDReceiver {
+  public:
+    // Constructor
+    ShiftLEDReceiver(ShiftLED& leds, Stream& stream, ReceiverProtocol protocol = RECEIVER_PROTOCOL_AUTO);
+
+    // Destructor
+    ~ShiftLEDReceiver();
+
+    // Announces the receiver to Adalight hosts ("Ada\n") and allocates the TPM2 staging buffer for the strip's
+    // capacity. Call after the stream has been started and the strip's capacity is set.
+    void begin();
+
+    // Sets the component order of the incoming pixels, e.g. "RGB" (default) or "GRBW"; 'N' skips a byte.
+    bool setInputOrder(const char* order);
+
+    // Sets how long a frame may stall between two bytes before it is dropped.
+    void setTimeout(uint16_t timeout_ms);
+
+    // Parses the available bytes; returns true if a frame was completed and sent.
+    bool run();
+
+    // Gets the number of frames sent.
+    uint32_t getFrameCount() const;
+
+    // Gets the number of frames abandoned because the stream stalled mid-frame.
+    uint32_t getDroppedFrames() const;
+
+    // Gets the number of frames rejected for a bad checksum or end byte.
+    uint32_t getCorruptFrames() const;
+
+  private:
+    // Maximum number of components per incoming pixel.
+    static const uint8_t MAX_INPUT_COMPONENTS = 8;
+
+    // Size of the buffer that reorders incoming pixels.
+    static const uint8_t SCRATCH_SIZE = 48;
+
+    /// @brief Position in the framing.
+    enum State {
+        STATE_IDLE,          // Waiting for the first byte of a frame
+        STATE_ADA_D,         // 'A' received
+        STATE_ADA_A,         // "Ad" received
+        STATE_ADA_HIGH,      // "Ada" received; next is the high byte of the LED count
+        STATE_ADA_LOW,
+        STATE_ADA_CHECKSUM,
+        STATE_TPM2_TYPE,     // 0xC9 received; next is the packet type
+        STATE_TPM2_SIZE_HIGH,
+        STATE_TPM2_SIZE_LOW,
+        STATE_PAYLOAD,
+        STATE_TPM2_END
+    };
+
+    ShiftLED& leds;
+    Stream& stream;
+    ReceiverProtocol protocol;
+    State state;
+    uint16_t timeout_ms;
+    uint32_t lastByte_ms;        // When the last byte of the current frame arrived
+
+    ColorComponent inputOrder[MAX_INPUT_COMPONENTS]; // Component of each incoming byte
+    uint8_t inputStride;         // Bytes per incoming pixel
+    int8_t sourceOffset[MAX_INPUT_COMPONENTS]; // Input offset of each strip component, or -1 if not sent
+    bool directCopy;             // Incoming pixels have the strip's layout and are read straight into the buffer
+
+    uint8_t headerHigh;          // High byte of the Adalight count or TPM2 size
+    uint8_t headerLow;
+    bool tpm2Frame;              // The current frame is a TPM2 packet and ends with an end byte
+    bool skipPayload;            // The TPM2 packet carries no pixel data
+    uint32_t payloadLength;      // Bytes in the current payload
+    uint32_t payloadPosition;    // Payload bytes received so far
+    PixelBuffer buffer;          // Strip buffer the current payload is written to
+    uint8_t* staging;            // Native-order pixels of the TPM2 frame being received; nullptr for Adalight only
+    size_t stagingSize;          // Bytes in staging; fixed by begin()
+    bool staged;                 // The current payload goes to staging instead of the strip
+    uint8_t* target;             // Where the current payload is written: buffer.data or staging
+    uint32_t targetLength;       // LEDs the current payload may write
+    uint32_t pixelsStored;       // Pixels written so far (reordering path)
+    uint8_t scratch[SCRATCH_SIZE];
+    uint8_t scratchFill;         // Bytes in scratch not yet stored
+
+    uint32_t frameCount;
+    uint32_t droppedFrames;
+    uint32_t corruptFrames;
+
+    // Advances the framing by one byte outside the payload; returns true if a frame is complete.
+    bool parseByte(uint8_t value);
+
+    // Prepares for a payload of the given length.
+    void startPayload(uint32_t length);
+
+    // Reads up to available payload bytes into the strip or staging; returns the number read.
+    size_t readPayload(size_t available);
+
+    // Reorders the complete pixels in scratch into the strip or staging.
+    void storeScratch();
+
+    // Gets the number of LEDs the current payload has written.
+    uint32_t getPixelsWritten() const;
+
+    // Copies a staged frame to the strip, then publishes and sends the frame.
+    void showFrame();
+
+    // Gives up on the current frame without sending it. Pixels it wrote to the strip are rewritten by the next
+    // frame; a staged frame never reaches the strip.
+    void abandonFrame();
+};
+
+#endif // SHIFT_LED_RECEIVER_H
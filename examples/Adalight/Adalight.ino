@@ -0,0 +1,33 @@
+// Adalight.ino
+
+#include <Arduino.h>
+#include <ShiftLED.h>
+#include <ShiftLEDReceiver.h>
+
+//---------------------------------------------------------------------------------------------------------------------
+// Configuration
+//---------------------------------------------------------------------------------------------------------------------
+
+const uint8_t DATA_PIN = MOSI;          // SPI data pin (MOSI, Pin 11 on Arduino Nano)
+const uint16_t TOTAL_LEDS = 60;         // Total number of LEDs; set the same count in the PC software
+const unsigned long BAUD_RATE = 500000; // Must match the PC software
+
+ShiftLED leds("WS2812B", TOTAL_LEDS, DATA_PIN);
+ShiftLEDReceiver receiver(leds, Serial);
+
+void setup() {
+    Serial.begin(BAUD_RATE);
+
+    leds.begin();
+    leds.setMaxPowerPerLED(180);
+    leds.setMaxPower(10000);
+
+    // Hosts send RGB; the receiver reorders it for the strip
+    receiver.setInputOrder("RGB");
+    receiver.begin();
+}
+
+void loop() {
+    // Shows each frame as soon as its last byte arrives
+    receiver.run();
+}
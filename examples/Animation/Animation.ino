@@ -0,0 +1,60 @@
+// Animation.ino
+
+#include <Arduino.h>
+#include <ShiftLED.h>
+#include <ShiftLEDAnimator.h>
+
+//---------------------------------------------------------------------------------------------------------------------
+// Configuration
+//---------------------------------------------------------------------------------------------------------------------
+
+const uint8_t DATA_PIN = MOSI;     // SPI data pin (MOSI, Pin 11 on Arduino Nano)
+const uint16_t TOTAL_LEDS = 10;    // Total number of LEDs
+const uint16_t TARGET_FPS = 50;    // Frames per second
+
+ShiftLED leds("GRB", TOTAL_LEDS, DATA_PIN);
+ShiftLEDAnimator animator(leds, TARGET_FPS);
+
+// Breathing orange on the first half, looping every two seconds
+const LEDKeyframe breathe[] = {
+    {0,    LEDColor(255, 87, 51), 20},
+    {1000, LEDColor(255, 87, 51), 255},
+    {2000, LEDColor(255, 87, 51), 20}
+};
+
+// Color cycle on the second half
+const LEDKeyframe cycle[] = {
+    {0,    LEDColor(51, 255, 87),  255},
+    {1500, LEDColor(51, 87, 255),  255},
+    {3000, LEDColor(255, 51, 168), 255},
+    {4500, LEDColor(51, 255, 87),  255}
+};
+
+void onDeadlineMissed(uint32_t frameNumber, uint32_t late_us) {
+    Serial.print("Frame ");
+    Serial.print(frameNumber);
+    Serial.print(" late by ");
+    Serial.print(late_us);
+    Serial.println(" us");
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    leds.reserveBrightness(); // The keyframes fade per-LED brightness
+    leds.setGamma(2.2);       // Allocates the gamma curve, so before begin()
+    leds.begin();
+    leds.setMaxPowerPerLED(180);
+    leds.setMaxPower(10000);
+
+    animator.setDeadlineMissedCallback(onDeadlineMissed);
+    animator.addTrack(0, TOTAL_LEDS / 2, breathe, 3, EASING_EASE_IN_OUT, true);
+    animator.addTrack(TOTAL_LEDS / 2, TOTAL_LEDS - TOTAL_LEDS / 2, cycle, 4, EASING_LINEAR, true);
+}
+
+void loop() {
+    // Sends a frame whenever one is due; no delay() needed
+    animator.run();
+
+    // Other work runs between frames
+}
@@ -0,0 +1,41 @@
+// Pipeline.ino
+//
+// Renders on one core of an ESP32 while the other one sends frames.
+
+#include <Arduino.h>
+#include <ShiftLED.h>
+
+//---------------------------------------------------------------------------------------------------------------------
+// Configuration
+//---------------------------------------------------------------------------------------------------------------------
+
+const uint8_t DATA_PIN = MOSI;  // SPI data pin
+const uint16_t TOTAL_LEDS = 300;
+
+ShiftLED leds("WS2812B", TOTAL_LEDS, DATA_PIN);
+
+// Render side: only pixel writes and publish()
+void renderTask(void*) {
+    uint8_t hue = 0;
+    for (;;) {
+        leds.fadeToBlack(32);
+        leds.fillRainbow(hue % TOTAL_LEDS, 20, hue);
+        leds.publish();
+        hue++;
+        delay(5);
+    }
+}
+
+void setup() {
+    leds.enablePipeline(); // Call before begin()
+    leds.begin();
+    leds.setMaxPowerPerLED(180);
+    leds.setMaxPower(10000);
+
+    xTaskCreatePinnedToCore(renderTask, "render", 4096, nullptr, 1, nullptr, 0);
+}
+
+void loop() {
+    // Output side: sends the newest published frame; nothing is sent while no new frame was published
+    leds.update();
+}
@@ -31,7 +31,7 @@ void setup() {
 
 void loop() {
     // Define the colors to cycle through
-    String colors[] = {
+    const char* colors[] = {
     "#FF5733", // Vibrant Orange
     "#33FF57", // Bright Green
     "#3357FF", // Deep Blue
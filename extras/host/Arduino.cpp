@@ -0,0 +1,137 @@
+// Arduino.cpp
+
+#include <stdio.h>
+#include "Arduino.h"
+#include "SPI.h"
+
+HardwareSerial Serial;
+SPIClass SPI;
+
+static uint64_t simulatedTime_ns = 0;
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the simulated time in microseconds; each read advances the clock by one microsecond.
+///
+unsigned long micros() {
+    unsigned long now = simulatedTime_ns / 1000;
+    simulatedTime_ns += 1000;
+    return now;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the simulated time in milliseconds.
+///
+unsigned long millis() {
+    return simulatedTime_ns / 1000000;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Advances the simulated clock by the given milliseconds.
+///
+void delay(unsigned long ms) {
+    simulatedTime_ns += (uint64_t)ms * 1000000;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Advances the simulated clock by the given microseconds.
+///
+void delayMicroseconds(unsigned int us) {
+    simulatedTime_ns += (uint64_t)us * 1000;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the simulated time in nanoseconds without advancing it.
+///
+uint64_t hostNanos() {
+    return simulatedTime_ns;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Advances the simulated clock.
+///
+void hostAdvanceNanos(uint64_t ns) {
+    simulatedTime_ns += ns;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Number formatting helpers.
+///
+size_t Print::print(long value) {
+    char text[24];
+    snprintf(text, sizeof(text), "%ld", value);
+    return print(text);
+}
+
+size_t Print::print(unsigned long value) {
+    char text[24];
+    snprintf(text, sizeof(text), "%lu", value);
+    return print(text);
+}
+
+size_t Print::print(double value) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.2f", value);
+    return print(text);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Writes to stdout unless output is disabled.
+///
+size_t HardwareSerial::write(const uint8_t* data, size_t size) {
+    if (!outputEnabled) return 0;
+    return fwrite(data, 1, size, stdout);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sends a single byte.
+///
+uint8_t SPIClass::transfer(uint8_t data) {
+    record(&data, 1);
+    return 0;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sends a buffer. Like the hardware, the buffer is overwritten with the (all-zero) received data.
+///
+void SPIClass::transfer(void* buffer, size_t count) {
+    record((const uint8_t*)buffer, count);
+    memset(buffer, 0, count);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Clears the recorded bytes and transfers.
+///
+void SPIClass::clearCapture() {
+    capture.clear();
+    transfers.clear();
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the simulated time at which a recorded byte started.
+///
+uint64_t SPIClass::getByteTime_ns(size_t index) const {
+    for (size_t i = transfers.size(); i-- > 0;) {
+        if (index >= transfers[i].offset) {
+            return transfers[i].start_ns + (uint64_t)(index - transfers[i].offset) * 8000000000ULL / transfers[i].clock;
+        }
+    }
+    return 0;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Records a run of bytes and advances the clock by their time on the wire.
+///
+void SPIClass::record(const uint8_t* data, size_t count) {
+    if (captureEnabled) {
+        SPITransferRecord transfer;
+        transfer.start_ns = hostNanos();
+        transfer.clock = settings.clock;
+        transfer.offset = capture.size();
+        transfer.length = count;
+        transfers.push_back(transfer);
+        capture.insert(capture.end(), data, data + count);
+    }
+
+    bytesTransferred += count;
+    hostAdvanceNanos((uint64_t)count * 8000000000ULL / settings.clock);
+}
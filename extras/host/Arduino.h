@@ -0,0 +1,161 @@
+// Arduino.h
+//
+// Minimal Arduino core for building ShiftLED on the host. Time is simulated: delays advance the
+// clock without sleeping, and every micros() read advances it by one microsecond so polling loops
+// make progress.
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <string>
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT  0x0
+#define OUTPUT 0x1
+
+#define MOSI 11
+
+#define PROGMEM
+#define memcpy_P memcpy
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+
+// Simulated clock
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Gets the simulated time in nanoseconds without advancing it.
+uint64_t hostNanos();
+
+// Advances the simulated clock.
+void hostAdvanceNanos(uint64_t ns);
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+
+/// @brief Subset of the Arduino String class backed by std::string.
+class String {
+  public:
+    String(const char* text = "") : text(text != nullptr ? text : "") {}
+    String(const std::string& text) : text(text) {}
+    String(char c) : text(1, c) {}
+    String(int value) : text(std::to_string(value)) {}
+    String(long value) : text(std::to_string(value)) {}
+    String(unsigned int value) : text(std::to_string(value)) {}
+    String(unsigned long value) : text(std::to_string(value)) {}
+
+    unsigned int length() const { return text.size(); }
+    const char* c_str() const { return text.c_str(); }
+    char* begin() { return &text[0]; }
+    char* end() { return &text[0] + text.size(); }
+    char charAt(unsigned int index) const { return index < text.size() ? text[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+
+    void toUpperCase() { for (char& c : text) c = toupper(c); }
+    void toLowerCase() { for (char& c : text) c = tolower(c); }
+    long toInt() const { return atol(text.c_str()); }
+
+    bool startsWith(const String& prefix) const { return text.compare(0, prefix.text.size(), prefix.text) == 0; }
+    bool endsWith(const String& suffix) const {
+        return text.size() >= suffix.text.size() &&
+               text.compare(text.size() - suffix.text.size(), suffix.text.size(), suffix.text) == 0;
+    }
+    int indexOf(char c) const {
+        size_t position = text.find(c);
+        return position == std::string::npos ? -1 : (int)position;
+    }
+    String substring(unsigned int from, unsigned int to) const { return String(text.substr(from, to - from)); }
+    String substring(unsigned int from) const { return String(text.substr(from)); }
+
+    String& operator+=(const String& other) { text += other.text; return *this; }
+    String operator+(const String& other) const { return String(text + other.text); }
+    bool operator==(const String& other) const { return text == other.text; }
+    bool operator==(const char* other) const { return text == other; }
+    bool operator!=(const String& other) const { return text != other.text; }
+
+  private:
+    std::string text;
+};
+
+/// @brief Formatted output on top of a byte sink, as in the Arduino core.
+class Print {
+  public:
+    virtual ~Print() {}
+
+    // Writes raw bytes and returns the number written.
+    virtual size_t write(const uint8_t* data, size_t size) = 0;
+
+    size_t print(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    size_t print(const String& text) { return print(text.c_str()); }
+    size_t print(char c) { return write((const uint8_t*)&c, 1); }
+    size_t print(int value) { return print((long)value); }
+    size_t print(unsigned int value) { return print((unsigned long)value); }
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(double value);
+
+    size_t println() { return print("\n"); }
+    template <typename T>
+    size_t println(const T& value) { return print(value) + println(); }
+};
+
+/// @brief Byte input on top of Print, as in the Arduino core.
+class Stream : public Print {
+  public:
+    // Gets the number of bytes that can be read without waiting.
+    virtual int available() = 0;
+
+    // Reads a byte, or returns -1 if none is available.
+    virtual int read() = 0;
+
+    // Gets the next byte without consuming it, or -1 if none is available.
+    virtual int peek() = 0;
+
+    // Reads up to length bytes and returns the number read.
+    virtual size_t readBytes(uint8_t* buffer, size_t length) {
+        size_t count = 0;
+        while (count < length) {
+            int c = read();
+            if (c < 0) break;
+            buffer[count++] = (uint8_t)c;
+        }
+        return count;
+    }
+};
+
+/// @brief Serial port that writes to stdout and never receives anything.
+class HardwareSerial : public Stream {
+  public:
+    void begin(unsigned long) {}
+
+    // Enables or disables output, e.g. to keep benchmarks quiet.
+    void setOutputEnabled(bool enabled) { outputEnabled = enabled; }
+
+    size_t write(const uint8_t* data, size_t size) override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    using Print::print;
+
+  private:
+    bool outputEnabled = true;
+};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
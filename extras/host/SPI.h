@@ -0,0 +1,84 @@
+// SPI.h
+//
+// Host SPI peripheral that records every transferred byte and advances the simulated clock by the
+// time the bytes take on the wire.
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <vector>
+#include "Arduino.h"
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+/// @brief SPI transaction settings.
+class SPISettings {
+  public:
+    SPISettings(uint32_t clock = 4000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+        : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+
+    uint32_t clock;
+    uint8_t bitOrder;
+    uint8_t dataMode;
+};
+
+/// @brief A contiguous run of captured bytes sent by one transfer call.
+struct SPITransferRecord {
+    uint64_t start_ns; // Simulated time of the first bit
+    uint32_t clock;    // SPI clock in Hz
+    size_t offset;     // Index of the first byte in the capture
+    size_t length;     // Number of bytes
+};
+
+/// @brief SPI peripheral with byte capture.
+class SPIClass {
+  public:
+    void begin() {}
+    void end() {}
+    void beginTransaction(SPISettings settings) { this->settings = settings; }
+    void endTransaction() {}
+
+    uint8_t transfer(uint8_t data);
+    void transfer(void* buffer, size_t count);
+
+    // Gets the settings of the current transaction.
+    const SPISettings& getSettings() const { return settings; }
+
+    // Enables or disables recording of transferred bytes (default on).
+    void setCaptureEnabled(bool enabled) { captureEnabled = enabled; }
+
+    // Clears the recorded bytes and transfers.
+    void clearCapture();
+
+    // Gets all recorded bytes.
+    const std::vector<uint8_t>& getCapture() const { return capture; }
+
+    // Gets the recorded transfers.
+    const std::vector<SPITransferRecord>& getTransfers() const { return transfers; }
+
+    // Gets the simulated time at which a recorded byte started.
+    uint64_t getByteTime_ns(size_t index) const;
+
+    // Gets the total number of bytes transferred, including while capture was disabled.
+    uint64_t getBytesTransferred() const { return bytesTransferred; }
+
+  private:
+    // Records a run of bytes and advances the clock by their time on the wire.
+    void record(const uint8_t* data, size_t count);
+
+    SPISettings settings;
+    bool captureEnabled = true;
+    uint64_t bytesTransferred = 0;
+    std::vector<uint8_t> capture;
+    std::vector<SPITransferRecord> transfers;
+};
+
+extern SPIClass SPI;
+
+#endif // HOST_SPI_H
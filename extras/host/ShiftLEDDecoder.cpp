@@ -0,0 +1,59 @@
+// ShiftLEDDecoder.cpp
+
+#include "ShiftLEDDecoder.h"
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Constructor for the waveform decoder.
+///
+ShiftLEDDecoder::ShiftLEDDecoder(SPIEncoding encoding) : slotWidth(getSlotWidth(encoding)) {}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Gets the number of SPI bits per LED bit for an encoding.
+///
+uint8_t ShiftLEDDecoder::getSlotWidth(SPIEncoding encoding) {
+    switch (encoding) {
+        case SPI_ENCODING_4BIT: return 4;
+        case SPI_ENCODING_3BIT: return 3;
+        case SPI_ENCODING_8BIT:
+        default:                return 8;
+    }
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Decodes the waveform and appends the LED data bytes. Returns false on an invalid bit pattern.
+///
+bool ShiftLEDDecoder::decode(const uint8_t* wire, size_t length, std::vector<uint8_t>& out) const {
+    size_t bitCount = length * 8;
+    size_t position = 0;
+    uint8_t value = 0;
+    uint8_t valueBits = 0;
+
+    while (position < bitCount) {
+        // Every LED bit starts with a rising edge; anything low before it is idle or reset time
+        if (!(wire[position / 8] & (0x80 >> (position % 8)))) {
+            position++;
+            continue;
+        }
+        if (position + slotWidth > bitCount) return false; // Truncated slot
+
+        // Count the high bits at the start of the slot; the rest must be low
+        uint8_t high = 0;
+        for (uint8_t i = 0; i < slotWidth; i++) {
+            bool bit = wire[(position + i) / 8] & (0x80 >> ((position + i) % 8));
+            if (bit) {
+                if (high != i) return false; // High after low within one slot
+                high++;
+            }
+        }
+        if (high == slotWidth) return false; // No falling edge
+
+        value = (value << 1) | (high * 2 > slotWidth ? 1 : 0);
+        if (++valueBits == 8) {
+            out.push_back(value);
+            valueBits = 0;
+        }
+        position += slotWidth;
+    }
+
+    return valueBits == 0;
+}
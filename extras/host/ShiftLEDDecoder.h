@@ -0,0 +1,28 @@
+// ShiftLEDDecoder.h
+
+#ifndef SHIFT_LED_DECODER_H
+#define SHIFT_LED_DECODER_H
+
+#include <vector>
+#include "ShiftLED.h"
+
+/// @brief Decodes captured single-wire SPI waveforms back into LED data bytes.
+///
+/// Each LED bit occupies a slot of 8, 4 or 3 SPI bits that starts high; a slot with more than half
+/// of its bits high is a '1'. Zero bits between slots (reset codes) are skipped.
+class ShiftLEDDecoder {
+  public:
+    // Constructor
+    explicit ShiftLEDDecoder(SPIEncoding encoding);
+
+    // Decodes the waveform and appends the LED data bytes. Returns false on an invalid bit pattern.
+    bool decode(const uint8_t* wire, size_t length, std::vector<uint8_t>& out) const;
+
+    // Gets the number of SPI bits per LED bit for an encoding.
+    static uint8_t getSlotWidth(SPIEncoding encoding);
+
+  private:
+    uint8_t slotWidth;  // SPI bits per LED bit
+};
+
+#endif // SHIFT_LED_DECODER_H
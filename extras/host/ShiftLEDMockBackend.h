@@ -0,0 +1,74 @@
+// ShiftLEDMockBackend.h
+
+#ifndef SHIFT_LED_MOCK_BACKEND_H
+#define SHIFT_LED_MOCK_BACKEND_H
+
+#include <vector>
+#include "ShiftLEDBackend.h"
+
+/// @brief Host-side backend that records frames and completes them on the simulated micros() clock.
+class ShiftLEDMockBackend : public ShiftLEDBackend {
+  public:
+    ShiftLEDMockBackend() : clockHz(0), spiMode(0), startTime_us(0), duration_us(0), frameCount(0), asynchronous(true),
+                            wireTime(true) {}
+
+    void begin(uint32_t clockHz, size_t maxLength, uint8_t spiMode) override {
+        (void)maxLength;
+        this->clockHz = clockHz;
+        this->spiMode = spiMode;
+    }
+
+    void end() override {}
+
+    void startTransfer(uint8_t* data, size_t length) override {
+        lastFrame.assign(data, data + length);
+        capture.insert(capture.end(), data, data + length);
+        startTime_us = micros();
+        duration_us = (uint32_t)((uint64_t)length * 8 * 1000000 / clockHz);
+        frameCount++;
+    }
+
+    bool isBusy() override {
+        return wireTime && (uint32_t)(micros() - startTime_us) < duration_us;
+    }
+
+    bool isAsynchronous() const override { return asynchronous; }
+
+    // Makes startTransfer() behave like a blocking transport (false) or a DMA engine (true, the default).
+    void setAsynchronous(bool asynchronous) { this->asynchronous = asynchronous; }
+
+    // Lets frames take their time on the wire (true, the default) or complete at once, so a benchmark only
+    // measures the encoding.
+    void setWireTimeEnabled(bool enabled) { wireTime = enabled; }
+
+    // Gets the bytes of the last frame handed to the backend.
+    const std::vector<uint8_t>& getLastFrame() const { return lastFrame; }
+
+    // Gets every byte handed to the backend since the last clearCapture(), e.g. the chunks of a streamed frame.
+    const std::vector<uint8_t>& getCapture() const { return capture; }
+
+    // Clears the bytes returned by getCapture().
+    void clearCapture() { capture.clear(); }
+
+    // Gets the number of frames (or chunks) handed to the backend.
+    uint32_t getFrameCount() const { return frameCount; }
+
+    // Gets the SPI clock the backend was started with.
+    uint32_t getClock() const { return clockHz; }
+
+    // Gets the SPI mode the backend was started with.
+    uint8_t getSPIMode() const { return spiMode; }
+
+  private:
+    uint32_t clockHz;
+    uint8_t spiMode;
+    uint32_t startTime_us;
+    uint32_t duration_us;   // Time the frame takes on the wire at clockHz
+    uint32_t frameCount;
+    bool asynchronous;      // Reported by isAsynchronous()
+    bool wireTime;          // isBusy() waits for the frame's duration on the wire
+    std::vector<uint8_t> lastFrame;
+    std::vector<uint8_t> capture;
+};
+
+#endif // SHIFT_LED_MOCK_BACKEND_H
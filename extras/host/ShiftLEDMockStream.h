@@ -0,0 +1,52 @@
+// ShiftLEDMockStream.h
+
+#ifndef SHIFT_LED_MOCK_STREAM_H
+#define SHIFT_LED_MOCK_STREAM_H
+
+#include <vector>
+#include "Arduino.h"
+
+/// @brief Host-side Stream that replays queued input bytes and records everything written to it.
+class ShiftLEDMockStream : public Stream {
+  public:
+    ShiftLEDMockStream() : position(0), chunkSize(0) {}
+
+    // Queues bytes to be read.
+    void feed(const uint8_t* data, size_t length) { input.insert(input.end(), data, data + length); }
+
+    // Limits how many bytes available() reports at once, like a UART receive buffer (0 = no limit).
+    void setChunkSize(size_t chunkSize) { this->chunkSize = chunkSize; }
+
+    // Gets the bytes written to the stream.
+    const std::vector<uint8_t>& getOutput() const { return output; }
+
+    int available() override {
+        size_t remaining = input.size() - position;
+        return (int)((chunkSize != 0 && remaining > chunkSize) ? chunkSize : remaining);
+    }
+
+    int read() override { return position < input.size() ? input[position++] : -1; }
+
+    int peek() override { return position < input.size() ? input[position] : -1; }
+
+    size_t readBytes(uint8_t* buffer, size_t length) override {
+        size_t remaining = input.size() - position;
+        if (length > remaining) length = remaining;
+        memcpy(buffer, input.data() + position, length);
+        position += length;
+        return length;
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        output.insert(output.end(), data, data + size);
+        return size;
+    }
+
+  private:
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+    size_t position;     // Next byte to read
+    size_t chunkSize;
+};
+
+#endif // SHIFT_LED_MOCK_STREAM_H
@@ -0,0 +1,1651 @@
+// benchmark.cpp
+//
+// Host benchmarks for ShiftLED. The captured SPI waveform is decoded and checked first, then the hot
+// paths are timed at several strip lengths. Pass --quick for a short run suitable for CI.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <thread>
+#include <vector>
+#include "ShiftLED.h"
+#include "ShiftLEDAnimator.h"
+#include "ShiftLEDController.h"
+#include "ShiftLEDDecoder.h"
+#include "ShiftLEDFixed.h"
+#include "ShiftLEDMockBackend.h"
+#include "ShiftLEDMockStream.h"
+#include "ShiftLEDReceiver.h"
+
+static volatile uint32_t sink; // Keeps results alive
+static std::atomic<uint32_t> allocations(0); // Calls to operator new, to catch allocations after begin()
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size != 0 ? size : 1);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Times body(i) over the given iterations and returns nanoseconds per iteration.
+///
+template <typename Body>
+static double measure_ns(uint32_t iterations, Body body) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        body(i);
+    }
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Prints one result line.
+///
+static void report(const char* name, uint32_t numLEDs, double ns) {
+    printf("%-28s %8u LEDs %14.1f ns/op %10.2f ns/LED\n", name, numLEDs, ns, numLEDs ? ns / numLEDs : 0.0);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Sends a frame and checks that the decoded waveform matches the scaled pixel data.
+///
+static bool verifyEncoding(SPIEncoding encoding) {
+    const uint16_t numLEDs = 37;
+    const uint8_t globalBrightness = 200;
+
+    ShiftLED leds("GRBW", numLEDs, MOSI);
+    leds.setEncoding(encoding);
+    leds.reserveBrightness();
+    leds.begin();
+    leds.setGlobalBrightness(globalBrightness);
+    for (uint16_t i = 0; i < numLEDs; i++) {
+        leds.setLEDColor(i, i * 7, 255 - i, i * 3, i, 0, 0, 255 - i * 5);
+    }
+
+    SPI.clearCapture();
+    leds.update();
+
+    std::vector<uint8_t> decoded;
+    ShiftLEDDecoder decoder(encoding);
+    if (!decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), decoded)) {
+        printf("FAIL: invalid waveform for encoding %d\n", encoding);
+        return false;
+    }
+    if (decoded.size() != numLEDs * 4u) {
+        printf("FAIL: decoded %u bytes, expected %u\n", (unsigned)decoded.size(), numLEDs * 4u);
+        return false;
+    }
+
+    for (uint16_t i = 0; i < numLEDs; i++) {
+        uint8_t brightness = 255 - i * 5;
+        uint16_t scale = (uint16_t)brightness + 1;
+        const uint8_t expected[4] = {(uint8_t)(255 - i), (uint8_t)(i * 7), (uint8_t)(i * 3), (uint8_t)i}; // GRBW
+        for (uint8_t c = 0; c < 4; c++) {
+            // Per-LED brightness as a multiply and shift, then the linear table rounds to nearest
+            uint8_t value = (((expected[c] * scale) >> 8) * globalBrightness + 127) / 255;
+            if (decoded[i * 4 + c] != value) {
+                printf("FAIL: LED %u component %u is %u, expected %u\n", i, c, decoded[i * 4 + c], value);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks color string parsing and the compile-time color literals.
+///
+static bool verifyColorParsing() {
+    using namespace ShiftLEDLiterals;
+    static_assert("#FF5733"_rgb.red == 0xFF && "#FF5733"_rgb.green == 0x57 && "#FF5733"_rgb.blue == 0x33,
+                  "#RRGGBB literal");
+    static_assert("#F53"_rgb.red == 0xFF && "#F53"_rgb.green == 0x55 && "#F53"_rgb.blue == 0x33, "#RGB literal");
+    static_assert("#a0b1c2"_rgb.red == 0xA0 && "#a0b1c2"_rgb.green == 0xB1 && "#a0b1c2"_rgb.blue == 0xC2,
+                  "lowercase #rrggbb literal");
+    static_assert("#fE9"_rgb.red == 0xFF && "#fE9"_rgb.green == 0xEE && "#fE9"_rgb.blue == 0x99, "mixed-case #RGB");
+    static_assert("#000000"_rgb.red == 0 && "#000"_rgb.blue == 0 && "#FFF"_rgb.green == 0xFF, "black and white");
+    // Malformed literals such as "#GG0000"_rgb, "#12345"_rgb or "FF5733"_rgb do not compile here
+    static_assert((2700_K).warmWhite == 229 && (2700_K).coldWhite == 25 && (2700_K).red == 0, "Kelvin literal");
+    static_assert((12000_K).warmWhite == 0 && (12000_K).coldWhite == 255, "Kelvin literal above the range");
+
+    struct Case {
+        const char* text;
+        size_t length;   // Parsed prefix of text
+        bool valid;
+        LEDColor color;
+    };
+    const Case cases[] = {
+        {"#FF5733", 7, true, LEDColor(0xFF, 0x57, 0x33)},
+        {"#f53", 4, true, LEDColor(0xFF, 0x55, 0x33)},
+        {"#00FF00 trailing", 7, true, LEDColor(0, 0xFF, 0)},
+        {"2700K", 5, true, LEDColor(0, 0, 0, 0, 229, 25)},
+        {"9000k", 5, true, LEDColor(0, 0, 0, 0, 0, 255)},
+        {"Orange", 6, true, LEDColor(0xFF, 0xA5, 0x00)},
+        {"pink", 4, true, LEDColor(0xFF, 0xC0, 0xCB)},
+        {"#GG0000", 7, false, LEDColor()},
+        {"#12345", 6, false, LEDColor()},
+        {"#", 1, false, LEDColor()},
+        {"27O0K", 5, false, LEDColor()},
+        {"notacolor", 9, false, LEDColor()},
+        {"", 0, false, LEDColor()},
+    };
+    for (const Case& test : cases) {
+        LEDColor color(1, 2, 3, 4, 5, 6);
+        bool valid = parseLEDColor(test.text, test.length, color);
+        if (valid != test.valid ||
+            (valid && (color.red != test.color.red || color.green != test.color.green ||
+                       color.blue != test.color.blue || color.white != test.color.white ||
+                       color.warmWhite != test.color.warmWhite || color.coldWhite != test.color.coldWhite))) {
+            printf("FAIL: \"%.*s\" parsed %s to %u/%u/%u/%u/%u/%u\n", (int)test.length, test.text,
+                   valid ? "valid" : "invalid", color.red, color.green, color.blue, color.white, color.warmWhite,
+                   color.coldWhite);
+            return false;
+        }
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Decodes the frame sent by one update() of an 8-bit encoded strip.
+///
+static std::vector<uint8_t> sendFrame(ShiftLED& leds) {
+    SPI.clearCapture();
+    leds.update();
+    std::vector<uint8_t> decoded;
+    ShiftLEDDecoder decoder(SPI_ENCODING_8BIT);
+    decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), decoded);
+    return decoded;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks the decoded output of gamma, per-channel white balance and temporal dithering.
+///
+static bool verifyColorCorrection() {
+    ShiftLED leds("RGB", 3, MOSI);
+    leds.setGamma(2.2f);
+    leds.begin();
+    leds.setLEDColor(0, 128, 255, 64);
+    std::vector<uint8_t> decoded = sendFrame(leds);
+    const uint8_t input[] = {128, 255, 64};
+    for (uint8_t c = 0; c < 3; c++) {
+        int expected = (int)(pow(input[c] / 255.0, 2.2) * 255.0 + 0.5);
+        if (decoded.size() != 9 || abs(decoded[c] - expected) > 1) {
+            printf("FAIL: gamma 2.2 maps %u to %u, expected %d\n", input[c], decoded.size() > c ? decoded[c] : 0,
+                   expected);
+            return false;
+        }
+    }
+
+    // Each channel is scaled by its own correction; the tables for it are allocated in begin()
+    ShiftLED balanced("RGB", 3, MOSI);
+    balanced.setColorCorrection(LEDColor(255, 128, 64));
+    balanced.begin();
+    balanced.setLEDColor(1, 200, 200, 200);
+    decoded = sendFrame(balanced);
+    if (decoded.size() != 9 || decoded[3] != 200 || decoded[4] != 100 || decoded[5] != 50) {
+        printf("FAIL: white balance sent %u/%u/%u, expected 200/100/50\n", decoded[3], decoded[4], decoded[5]);
+        return false;
+    }
+
+    // A padding component first in the order does not disturb the shared correction
+    ShiftLED padded("NRGB", 1, MOSI);
+    padded.begin();
+    padded.setColorCorrection(LEDColor(200, 200, 200)); // Shared by all channels, so it fits the one table
+    padded.setLEDColor(0, 100, 255, 0);
+    decoded = sendFrame(padded);
+    if (decoded.size() != 4 || decoded[0] != 0 || decoded[1] != 78 || decoded[2] != 200 || decoded[3] != 0) {
+        printf("FAIL: padded strip sent %u/%u/%u, expected 78/200/0\n", decoded[1], decoded[2], decoded[3]);
+        return false;
+    }
+
+    // Dithered over 256 frames, a level of 3 at global brightness 128 averages 1.51 instead of rounding to 2
+    ShiftLED dithered("RGB", 1, MOSI);
+    dithered.begin();
+    dithered.setDithering(true);
+    dithered.setGlobalBrightness(128);
+    dithered.setLEDColor(0, 3, 0, 0);
+    uint32_t sum = 0;
+    for (uint16_t frame = 0; frame < 256; frame++) {
+        decoded = sendFrame(dithered);
+        if (decoded.size() != 3 || decoded[0] < 1 || decoded[0] > 2) {
+            printf("FAIL: dithered frame %u sent red %u\n", frame, decoded.empty() ? 0 : decoded[0]);
+            return false;
+        }
+        sum += decoded[0];
+    }
+    double target = 3 * 128 / 255.0 * 256;
+    if (fabs(sum - target) > 1.0) {
+        printf("FAIL: dithered red sums to %u over 256 frames, expected %.1f\n", sum, target);
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks that update() sends only the prefix up to the last modified LED and counts the bytes it skips.
+///
+static bool verifyDirtyTracking() {
+    const uint32_t numLEDs = 100;
+    ShiftLED leds("GRB", numLEDs, MOSI);
+    leds.begin();
+    leds.update(); // The first frame is always sent whole
+
+    // Editing LED 4 sends LEDs 0-4 (24 bytes each) and the byte that pulls the line low; the other 95 stay latched
+    leds.setLEDColor(4, 10, 20, 30);
+    std::vector<uint8_t> decoded = sendFrame(leds);
+    size_t sent = SPI.getCapture().size();
+    if (decoded.size() != 5 * 3u || decoded[4 * 3] != 20 || sent != 5 * 24u + 1 || leds.getBytesSaved() != 95 * 24u) {
+        printf("FAIL: dirty prefix sent %u bytes (%u LEDs), saved %u\n", (unsigned)sent,
+               (unsigned)decoded.size() / 3, leds.getBytesSaved());
+        return false;
+    }
+
+    // Nothing changed: nothing is sent and the whole frame counts as saved
+    sendFrame(leds);
+    if (!SPI.getTransfers().empty() || leds.getBytesSaved() != 195 * 24u) {
+        printf("FAIL: unchanged strip sent %u transfers\n", (unsigned)SPI.getTransfers().size());
+        return false;
+    }
+
+    // With tracking off the whole strip goes out again
+    leds.setDirtyTracking(false);
+    decoded = sendFrame(leds);
+    if (decoded.size() != numLEDs * 3u || leds.getBytesSaved() != 195 * 24u) {
+        printf("FAIL: untracked strip sent %u LEDs\n", (unsigned)decoded.size() / 3);
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Exposes the running power weight sum of a strip for checking against a full recompute.
+class PowerSumProbe : public ShiftLED {
+  public:
+    PowerSumProbe(const char* ledType, uint32_t numLEDs) : ShiftLED(ledType, numLEDs, MOSI) {}
+
+    // Returns false if the running sum is current but differs from a recompute; counts the checks made.
+    bool check(uint32_t& checks) {
+        if (powerWeightSumStale) return true;
+        checks++;
+        return powerWeightSum == recomputePowerWeightSum();
+    }
+};
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks the incrementally updated power sum against a full recompute after a mix of pixel edits.
+///
+static bool verifyPowerSum(PixelStorage storage) {
+    const uint32_t numLEDs = 50;
+    PowerSumProbe leds("GRBW", numLEDs);
+    leds.setPixelStorage(storage);
+    leds.reserve(numLEDs + 10);
+    leds.reserveBrightness();
+    leds.begin();
+
+    const uint8_t pixels[] = {10, 20, 30, 40, 200, 0, 90, 5, 1, 2, 3, 4};
+    uint32_t seed = 12345;
+    uint32_t checks = 0;
+    for (uint32_t step = 0; step < 2000; step++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t r = seed >> 8;
+        uint32_t n = leds.getNumLEDs();
+        uint32_t index = r % n;
+        uint8_t brightness = (r >> 4) % 3 == 0 ? (r >> 8) & 0xFF : 255;
+        switch (r % 7) {
+            case 0: leds.setLEDColor(index, r & 0xFF, (r >> 3) & 0xFF, 7, (r >> 5) & 0x3F, 0, 0, brightness); break;
+            case 1: leds.fillRange(index, (r >> 6) % 12, LEDColor((r >> 2) & 0xFF, 0, 40, 9), brightness); break;
+            case 2: leds.shift((int32_t)((r >> 5) % 9) - 4); break;
+            case 3: leds.copyRange(index, (r >> 7) % n, (r >> 9) % 8); break;
+            case 4: leds.setPixels(index, pixels, n - index < 3 ? n - index : 3, PIXEL_FORMAT_NATIVE); break;
+            case 5: leds.setAllLEDs((r >> 1) & 0xFF, 0, (r >> 9) & 0xFF, 3, 0, 0, brightness); break;
+            case 6: leds.setNumLEDs(numLEDs - 10 + (r >> 6) % 21); break;
+        }
+        if (!leds.check(checks)) {
+            printf("FAIL: power sum drifted after step %u (operation %u)\n", step, r % 7);
+            return false;
+        }
+        sink = leds.estimatePowerConsumption(); // Brings a stale sum up to date for the next deltas
+    }
+    if (checks < 1500) {
+        printf("FAIL: power sum was only current for %u of 2000 edits\n", checks);
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks that asynchronous frames through the mock backend match the blocking waveform.
+///
+static bool verifyAsync() {
+    const uint16_t numLEDs = 50;
+    ShiftLEDMockBackend backend; // Must outlive the strip using it
+    ShiftLED blocking("GRB", numLEDs, MOSI);
+    ShiftLED async("GRB", numLEDs, MOSI);
+    async.setBackend(&backend);
+    blocking.begin();
+    async.begin();
+
+    for (uint16_t i = 0; i < numLEDs; i++) {
+        blocking.setLEDColor(i, i, i * 2, i * 3);
+        async.setLEDColor(i, i, i * 2, i * 3);
+    }
+
+    SPI.clearCapture();
+    blocking.update();
+    async.updateAsync();
+    if (!async.isBusy()) {
+        printf("FAIL: asynchronous frame completed immediately\n");
+        return false;
+    }
+    while (async.isBusy()) {}
+
+    std::vector<uint8_t> expected, actual;
+    ShiftLEDDecoder decoder(SPI_ENCODING_8BIT);
+    decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), expected);
+    decoder.decode(backend.getLastFrame().data(), backend.getLastFrame().size(), actual);
+    if (expected != actual || actual.size() != numLEDs * 3u) {
+        printf("FAIL: asynchronous frame differs from blocking frame\n");
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks that palette storage sends the same frames and power estimate as direct storage.
+///
+static bool verifyPalette(PixelStorage storage) {
+    const uint16_t numLEDs = 37;
+    const LEDColor colors[] = {LEDColor(255, 0, 0), LEDColor(0, 80, 0, 10), LEDColor(1, 2, 3), LEDColor(0, 0, 0, 255),
+                               LEDColor(90, 90, 0)};
+    const uint8_t pixels[] = {1, 2, 3, 4, 0, 80, 0, 10, 255, 0, 0, 0};
+
+    ShiftLED direct("GRBW", numLEDs, MOSI);
+    ShiftLED indexed("GRBW", numLEDs, MOSI);
+    indexed.setPixelStorage(storage);
+    ShiftLED* strips[] = {&direct, &indexed};
+    std::vector<uint8_t> decoded[2];
+
+    for (uint8_t s = 0; s < 2; s++) {
+        ShiftLED& leds = *strips[s];
+        leds.reserveBrightness();
+        leds.begin();
+        for (uint16_t i = 0; i < numLEDs; i++) {
+            leds.setLEDColor(i, colors[i % 5], i % 3 == 0 ? 255 : 100);
+        }
+        leds.fillRange(3, 10, colors[4]);
+        leds.copyRange(1, 6, 20);
+        leds.copyRange(8, 5, 9);
+        leds.shift(3);
+        leds.shift(-2);
+        leds.setPixels(2, pixels, 3, PIXEL_FORMAT_RGBW);
+
+        SPI.clearCapture();
+        leds.update();
+        ShiftLEDDecoder decoder(SPI_ENCODING_8BIT);
+        decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), decoded[s]);
+    }
+
+    if (decoded[0] != decoded[1] || decoded[0].size() != numLEDs * 4u) {
+        printf("FAIL: palette storage %d sends a different frame\n", storage);
+        return false;
+    }
+    if (direct.estimatePowerConsumption() != indexed.estimatePowerConsumption()) {
+        printf("FAIL: palette storage %d estimates %u mW, expected %u mW\n", storage,
+               indexed.estimatePowerConsumption(), direct.estimatePowerConsumption());
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks that a controller splits pixels across outputs and keeps them within the shared budget.
+///
+static bool verifyController() {
+    ShiftLEDMockBackend firstBackend, secondBackend; // Must outlive the outputs using them
+    ShiftLED first("GRB", 20, MOSI);
+    ShiftLED second("RGBW", 30, MOSI);
+    first.setBackend(&firstBackend);
+    second.setBackend(&secondBackend);
+
+    ShiftLEDController controller;
+    controller.addOutput(first);
+    controller.addOutput(second);
+    controller.begin();
+
+    uint8_t pixels[50 * 3];
+    for (uint16_t i = 0; i < 50; i++) {
+        pixels[i * 3] = i;
+        pixels[i * 3 + 1] = i * 2;
+        pixels[i * 3 + 2] = i * 3;
+    }
+    controller.setPixels(0, pixels, 50);
+    controller.setMaxPowerPerLED(240);
+    controller.setMaxPower(1000);
+
+    controller.updateAsync();
+    if (!firstBackend.isBusy() || !secondBackend.isBusy()) {
+        printf("FAIL: controller outputs are not sending in parallel\n");
+        return false;
+    }
+    while (controller.isBusy()) {}
+
+    uint8_t brightness = controller.getActualGlobalBrightness();
+    if (controller.estimatePowerConsumption() > 1000 || brightness == 255) {
+        printf("FAIL: controller exceeds the shared power budget\n");
+        return false;
+    }
+
+    std::vector<uint8_t> decoded;
+    ShiftLEDDecoder decoder(SPI_ENCODING_8BIT);
+    for (uint16_t i = 0; i < 50; i++) {
+        bool onFirst = i < 20;
+        if (i == 0 || i == 20) {
+            const std::vector<uint8_t>& frame = onFirst ? firstBackend.getLastFrame() : secondBackend.getLastFrame();
+            decoded.clear();
+            decoder.decode(frame.data(), frame.size(), decoded);
+        }
+        uint16_t local = onFirst ? i : i - 20;
+        const uint8_t* led = &decoded[local * (onFirst ? 3 : 4)];
+        uint8_t red = (i * brightness + 127) / 255, green = (i * 2 * brightness + 127) / 255;
+        if ((onFirst ? led[1] : led[0]) != red || (onFirst ? led[0] : led[1]) != green) {
+            printf("FAIL: controller LED %u has the wrong color\n", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks the bit patterns of a chip profile and that back-to-back frames wait only for its reset time.
+///
+static bool verifyTiming(const char* chip, uint8_t onePattern, uint8_t zeroPattern, uint16_t reset_us) {
+    ShiftLED leds(chip, 10, MOSI);
+    leds.begin();
+    leds.setDirtyTracking(false);
+    leds.setAllLEDs(0xA5, 0x5A, 0xFF);
+
+    SPI.clearCapture();
+    leds.update();
+    leds.update();
+
+    // Transfers: frame, reset byte, frame, reset byte
+    const std::vector<SPITransferRecord>& transfers = SPI.getTransfers();
+    if (transfers.size() != 4 || transfers[0].length != 240 || transfers[0].clock != 8000000) {
+        printf("FAIL: %s sent %u transfers, expected 4\n", chip, (unsigned)transfers.size());
+        return false;
+    }
+    for (size_t i = 0; i < transfers[0].length; i++) {
+        uint8_t wire = SPI.getCapture()[transfers[0].offset + i];
+        if (wire != onePattern && wire != zeroPattern) {
+            printf("FAIL: %s sent pattern 0x%02X\n", chip, wire);
+            return false;
+        }
+    }
+
+    // The reset time starts when the last data bit has left
+    uint64_t frameEnd_ns = transfers[0].start_ns + transfers[0].length * 1000;
+    uint64_t gap_us = (transfers[2].start_ns - frameEnd_ns) / 1000;
+    if (gap_us < reset_us || gap_us > reset_us + 20u) {
+        printf("FAIL: %s frames are %u us apart, expected %u us\n", chip, (unsigned)gap_us, reset_us);
+        return false;
+    }
+
+    std::vector<uint8_t> decoded;
+    ShiftLEDDecoder decoder(SPI_ENCODING_8BIT);
+    decoder.decode(SPI.getCapture().data() + transfers[0].offset, transfers[0].length, decoded);
+    if (decoded.size() != 30 || decoded[0] != 0x5A || decoded[1] != 0xA5 || decoded[2] != 0xFF) {
+        printf("FAIL: %s frame decodes to the wrong colors\n", chip);
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks the APA102 frame layout and that per-LED brightness goes into the hardware field.
+///
+static bool verifyClocked() {
+    const uint16_t numLEDs = 40;
+    ShiftLED leds("APA102", numLEDs, MOSI);
+    leds.reserveBrightness();
+    leds.begin();
+    if (SPI.getSettings().clock != 20000000 || SPI.getSettings().dataMode != SPI_MODE0) {
+        printf("FAIL: APA102 runs at %u Hz in mode %u\n", SPI.getSettings().clock, SPI.getSettings().dataMode);
+        return false;
+    }
+    for (uint16_t i = 0; i < numLEDs; i++) {
+        leds.setLEDColor(i, 200, i * 5, 255 - i, 0, 0, 0, i * 6);
+    }
+
+    SPI.clearCapture();
+    leds.update();
+    const std::vector<uint8_t>& wire = SPI.getCapture();
+    const std::vector<SPITransferRecord>& transfers = SPI.getTransfers();
+    size_t length = 4 + numLEDs * 4 + 4 + (numLEDs + 15) / 16;
+    if (transfers.empty() || transfers[0].length != length || wire[0] != 0 || wire[3] != 0 || wire[length - 1] != 0) {
+        printf("FAIL: APA102 frame is %u bytes, expected %u\n", transfers.empty() ? 0 : (unsigned)transfers[0].length,
+               (unsigned)length);
+        return false;
+    }
+
+    for (uint16_t i = 0; i < numLEDs; i++) {
+        const uint8_t* led = &wire[4 + i * 4];
+        uint8_t brightness = i * 6;
+        uint8_t level = led[0] & 0x1F;
+        const uint8_t expected[3] = {(uint8_t)(255 - i), (uint8_t)(i * 5), 200}; // BGR
+        if ((led[0] & 0xE0) != 0xE0 || level != (brightness * 31 + 254) / 255) {
+            printf("FAIL: APA102 LED %u has header 0x%02X\n", i, led[0]);
+            return false;
+        }
+        for (uint8_t c = 0; c < 3; c++) {
+            // Hardware level times color matches the brightness-scaled color to within one color step
+            int actual = led[1 + c] * level * 255 / 31;
+            int target = expected[c] * brightness;
+            if (abs(actual - target) > 255 * (level + 31) / 31) {
+                printf("FAIL: APA102 LED %u component %u is %u at level %u\n", i, c, led[1 + c], level);
+                return false;
+            }
+        }
+    }
+
+    // Red 200 at brightness 6 is sent as 145 at hardware level 1 instead of 5 at full level
+    if (wire[4 + 1 * 4 + 3] < 128) {
+        printf("FAIL: dim APA102 LED lost its color depth\n");
+        return false;
+    }
+
+    // 4 bytes at 20 MHz per LED against 24 bytes at 8 MHz
+    uint64_t wire_ns = (uint64_t)transfers[0].length * 8000000000ULL / transfers[0].clock;
+    printf("APA102: %u LEDs in %.1f us on the wire (single-wire: %u us)\n", numLEDs, wire_ns / 1000.0,
+           numLEDs * 24);
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks that only power zones over their budget are scaled, and that zones are sent whole.
+///
+static bool verifyPowerZones() {
+    ShiftLED leds("GRB", 30, MOSI);
+    leds.setMaxPowerPerLED(60);
+    const LEDChannelCurrent current = {20, 20, 20, 0, 0, 0};
+    if (!leds.addPowerZone(0, 10, 100) || !leds.addPowerZone(10, 10, 1000) ||
+        !leds.addPowerZone(20, 10, 300, current) || leds.addPowerZone(25, 10, 100)) {
+        printf("FAIL: power zones rejected or overlap accepted\n");
+        return false;
+    }
+    leds.begin();
+    leds.setAllLEDs(255, 255, 255);
+
+    SPI.clearCapture();
+    leds.update();
+    std::vector<uint8_t> decoded;
+    ShiftLEDDecoder decoder(SPI_ENCODING_8BIT);
+    decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), decoded);
+
+    // 10 white LEDs at 60 mW, and 10 at 3 x 20 mA from 5 V
+    PowerZoneReading first = leds.getPowerZoneReading(0);
+    PowerZoneReading second = leds.getPowerZoneReading(1);
+    PowerZoneReading third = leds.getPowerZoneReading(2);
+    if (first.desiredPower_mW != 600 || first.power_mW > 100 || first.power_mW < 90 ||
+        second.power_mW != 600 || second.scale != 255 ||
+        third.desiredPower_mW != 3000 || third.power_mW > 300 || third.power_mW < 270) {
+        printf("FAIL: power zones read %u/%u, %u/%u and %u/%u mW\n", first.power_mW, first.desiredPower_mW,
+               second.power_mW, second.desiredPower_mW, third.power_mW, third.desiredPower_mW);
+        return false;
+    }
+    if (decoded.size() != 90 || decoded[0] > 45 || decoded[30] != 255 || decoded[60] > 30) {
+        printf("FAIL: power zones send %u, %u and %u\n", decoded[0], decoded[30], decoded[60]);
+        return false;
+    }
+
+    // A change inside the second zone sends the strip up to the end of that zone
+    leds.setLEDColor(12, 0, 0, 0);
+    SPI.clearCapture();
+    leds.update();
+    if (SPI.getTransfers().empty() || SPI.getTransfers()[0].length != 20 * 24) {
+        printf("FAIL: dirty power zone sent %u bytes\n", SPI.getTransfers().empty() ? 0u :
+               (unsigned)SPI.getTransfers()[0].length);
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks that frames streamed in chunks match whole frames, with and without a backend, and that single-wire
+/// chips only stream through an asynchronous backend.
+///
+static bool verifyStreaming() {
+    const uint16_t numLEDs = 100;
+    const uint16_t chunkLEDs = 16;
+    const char* types[] = {"GRB", "APA102"};
+    for (uint8_t t = 0; t < 2; t++) {
+        // No backend, an asynchronous one and a blocking one
+        for (uint8_t mode = 0; mode < 3; mode++) {
+            ShiftLEDMockBackend backend; // Must outlive the strip using it
+            backend.setAsynchronous(mode == 1);
+            ShiftLED whole(types[t], numLEDs, MOSI);
+            ShiftLED streamed(types[t], numLEDs, MOSI);
+            if (mode != 0) streamed.setBackend(&backend);
+            streamed.setWireChunkSize(chunkLEDs);
+            ShiftLED* strips[] = {&whole, &streamed};
+            for (ShiftLED* leds : strips) {
+                leds->addPowerZone(10, 40, 500); // Spans several chunks and is over budget
+                leds->reserveBrightness();
+                leds->begin();
+                leds->setGlobalBrightness(220);
+                leds->setMaxPowerPerLED(60);
+                for (uint16_t i = 0; i < numLEDs; i++) {
+                    leds->setLEDColor(i, i * 2, 255 - i, i * 5, 0, 0, 0, 255 - i);
+                }
+            }
+
+            SPI.clearCapture();
+            whole.update();
+            std::vector<uint8_t> expected(SPI.getCapture().begin(),
+                                          SPI.getCapture().begin() + SPI.getTransfers()[0].length);
+
+            SPI.clearCapture();
+            backend.clearCapture();
+            streamed.update();
+            const std::vector<uint8_t>& actual = (mode != 0) ? backend.getCapture() : SPI.getCapture();
+            if (actual.size() < expected.size() || !std::equal(expected.begin(), expected.end(), actual.begin())) {
+                printf("FAIL: streamed %s frame differs from the whole frame\n", types[t]);
+                return false;
+            }
+
+            // One transfer per chunk, plus the APA102 start and end frames or the reset byte. Blocking chunks would
+            // leave the line of a single-wire chip idle long enough to latch, so it sends whole frames instead.
+            bool fallback = t == 0 && mode != 1;
+            uint32_t chunks = fallback ? 1 : (numLEDs + chunkLEDs - 1) / chunkLEDs + (t == 1 ? 2 : 0);
+            uint32_t transfers = (mode != 0) ? backend.getFrameCount() : SPI.getTransfers().size() - 1;
+            PowerZoneReading wholeZone = whole.getPowerZoneReading(0);
+            PowerZoneReading streamedZone = streamed.getPowerZoneReading(0);
+            if (transfers != chunks || streamedZone.power_mW != wholeZone.power_mW ||
+                streamedZone.desiredPower_mW != wholeZone.desiredPower_mW || streamedZone.scale != wholeZone.scale ||
+                wholeZone.scale == 255) {
+                printf("FAIL: streamed %s frame took %u transfers, zone reads %u/%u mW\n", types[t], transfers,
+                       streamedZone.power_mW, wholeZone.power_mW);
+                return false;
+            }
+            if (streamed.setWireChunkSize(chunkLEDs * 2)) {
+                printf("FAIL: %s strip in mode %u resized its chunks after begin()\n", types[t], mode);
+                return false;
+            }
+        }
+    }
+
+    // Indices past 65535 address their own LEDs
+    const uint32_t longLEDs = 70000;
+    ShiftLEDMockBackend backend;
+    ShiftLED leds("GRB", longLEDs, MOSI);
+    leds.setBackend(&backend);
+    leds.setWireChunkSize(256);
+    leds.begin();
+    leds.setLEDColor(65536 + 5, 10, 20, 30);
+    leds.setLEDColor(longLEDs - 1, 40, 50, 60);
+
+    leds.update();
+    std::vector<uint8_t> decoded;
+    ShiftLEDDecoder decoder(SPI_ENCODING_8BIT);
+    decoder.decode(backend.getCapture().data(), backend.getCapture().size(), decoded);
+    if (leds.getNumLEDs() != longLEDs || decoded.size() != longLEDs * 3u || decoded[5 * 3] != 0 ||
+        decoded[(65536 + 5) * 3] != 20 || decoded[(longLEDs - 1) * 3 + 2] != 60) {
+        printf("FAIL: %u-LED strip decoded to %u bytes\n", longLEDs, (unsigned)decoded.size());
+        return false;
+    }
+
+    // A gradient over the whole strip keeps rising past index 65535
+    leds.fillGradient(0, longLEDs, LEDColor(0, 0, 0), LEDColor(255, 0, 0));
+    backend.clearCapture();
+    leds.update();
+    decoded.clear();
+    decoder.decode(backend.getCapture().data(), backend.getCapture().size(), decoded);
+    if (decoded.size() != longLEDs * 3u || decoded[65535 * 3 + 1] < 230 ||
+        decoded[65536 * 3 + 1] < decoded[65535 * 3 + 1] || decoded[(longLEDs - 1) * 3 + 1] != 255) {
+        printf("FAIL: long gradient reads %u at LED 65535 and %u at LED 65536\n", decoded[65535 * 3 + 1],
+               decoded[65536 * 3 + 1]);
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks that resizing within the capacity keeps the pixels and buffers, and that caller-provided buffers
+/// send the same frames.
+///
+static bool verifyCapacity() {
+    ShiftLED leds("GRB", 10, MOSI);
+    leds.reserve(40);
+    for (uint8_t i = 0; i < 10; i++) {
+        leds.setLEDColor(i, i, 100, 200, 0, 0, 0, i == 2 ? 127 : 255);
+    }
+    leds.begin();
+    size_t footprint = leds.getMemoryFootprint();
+    const uint8_t* pixels = leds.getPixelBuffer().data;
+
+    // Shrinking and growing again keeps the pixels in front and turns off the ones the strip grows over
+    if (!leds.setNumLEDs(4) || !leds.setNumLEDs(30) || leds.setNumLEDs(41)) {
+        printf("FAIL: resizing within a capacity of %u\n", leds.getCapacity());
+        return false;
+    }
+    leds.setLEDColor(20, 0, 0, 90);
+    SPI.clearCapture();
+    leds.update();
+    std::vector<uint8_t> decoded;
+    ShiftLEDDecoder decoder(SPI_ENCODING_8BIT);
+    decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), decoded);
+    if (leds.getNumLEDs() != 30 || decoded.size() != 30 * 3u || decoded[3 * 3 + 1] != 3 || decoded[2 * 3] != 50 ||
+        decoded[5 * 3 + 1] != 0 || decoded[9 * 3 + 2] != 0 || decoded[20 * 3 + 2] != 90) {
+        printf("FAIL: resized strip decoded to %u bytes\n", (unsigned)decoded.size());
+        return false;
+    }
+    size_t minimum = sizeof(ShiftLED) + 40 * 4 + ShiftLEDBuffers::frameSize(40, 3) + 256 * sizeof(uint16_t);
+    if (leds.getPixelBuffer().data != pixels || leds.getMemoryFootprint() != footprint || footprint != minimum) {
+        printf("FAIL: resizing reallocated; footprint %u bytes, expected %u\n", (unsigned)leds.getMemoryFootprint(),
+               (unsigned)minimum);
+        return false;
+    }
+
+    // The per-LED brightness array stays unallocated until a strip uses it
+    ShiftLED plain("GRB", 400, MOSI);
+    size_t plainFootprint = plain.getMemoryFootprint();
+    plain.begin();
+    if (plain.getPixelBuffer().brightness != nullptr || plain.getMemoryFootprint() != plainFootprint + 512) {
+        printf("FAIL: begin() grew the footprint from %u to %u bytes\n", (unsigned)plainFootprint,
+               (unsigned)plain.getMemoryFootprint());
+        return false;
+    }
+
+    // A palette strip grown over an odd index clears only the LEDs past the old end
+    ShiftLED indexed("GRB", 9, MOSI);
+    indexed.setPixelStorage(PIXEL_STORAGE_PALETTE4);
+    indexed.begin();
+    indexed.setAllLEDs(LEDColor(255, 0, 0));
+    indexed.setNumLEDs(5);
+    indexed.setNumLEDs(9);
+    SPI.clearCapture();
+    indexed.update();
+    decoded.clear();
+    decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), decoded);
+    if (decoded.size() != 9 * 3u || decoded[4 * 3 + 1] != 255 || decoded[5 * 3 + 1] != 0 || decoded[8 * 3 + 1] != 0) {
+        printf("FAIL: resized palette strip decoded to %u bytes\n", (unsigned)decoded.size());
+        return false;
+    }
+
+    // Caller-provided buffers hold at most their capacity and never come from the heap
+    const uint32_t capacity = 16;
+    static uint8_t pixelBuffer[capacity * 3];
+    static uint8_t brightnessBuffer[capacity];
+    static uint8_t wireBuffer[ShiftLEDBuffers::frameSize(capacity, 3)];
+    ShiftLEDBuffers buffers = {pixelBuffer, brightnessBuffer, wireBuffer, sizeof(wireBuffer), capacity};
+    ShiftLEDFixed<ShiftLEDOrder::GRB> fixed(20, MOSI, buffers);
+    fixed.begin();
+    for (uint8_t i = 0; i < capacity; i++) {
+        fixed.setLEDColor(i, i, 100, 200, 0, 0, 0, i == 2 ? 127 : 255);
+    }
+    SPI.clearCapture();
+    fixed.update();
+    decoded.clear();
+    decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), decoded);
+    if (fixed.getNumLEDs() != capacity || fixed.getPixelBuffer().data != pixelBuffer || fixed.setNumLEDs(17) ||
+        decoded.size() != capacity * 3u || decoded[3 * 3 + 1] != 3 || decoded[2 * 3] != 50 ||
+        decoded[15 * 3 + 2] != 200 || fixed.estimatePowerConsumption() == 0) {
+        printf("FAIL: strip on static buffers decoded to %u bytes\n", (unsigned)decoded.size());
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks that nothing allocates after begin(): drawing, resizing, power zones, gamma and white balance reuse
+/// what was set up before, and setters that would allocate are refused.
+///
+static bool verifyNoAllocation() {
+    ShiftLEDMockBackend backend; // Must outlive the strip using it
+    ShiftLED leds("GRBW", 60, MOSI);
+    leds.setBackend(&backend);
+    leds.setWireChunkSize(16);
+    leds.reserve(80);
+    leds.reserveBrightness();
+    leds.setGamma(2.2f);
+    leds.setColorCorrection(LEDColor(255, 200, 180, 255)); // One table per channel
+    leds.addPowerZone(0, 30, 500);
+    leds.begin();
+
+    // A heap strip that never used per-LED brightness, gamma or zones before begin()
+    ShiftLED plain("GRB", 20, MOSI);
+    plain.begin();
+
+    // The backend keeps its capture buffers from the first frame
+    leds.update();
+    backend.clearCapture();
+    uint32_t before = allocations;
+
+    for (uint32_t i = 0; i < 60; i++) {
+        leds.setLEDColor(i, i * 4, 255 - i, i, 30, 0, 0, 100 + i);
+    }
+    leds.setGamma(2.8f);
+    leds.setGamma(1.0f);
+    bool accepted = leds.setColorCorrection(LEDColor(255, 180, 160, 200));
+    leds.clearPowerZones();
+    accepted = leds.addPowerZone(10, 20, 300) && accepted;
+    accepted = leds.setNumLEDs(80) && leds.setNumLEDs(40) && accepted;
+    leds.fillRainbow(0, 40, 10, 200);
+    leds.fadeToBlack(16);
+    leds.setGlobalBrightness(120);
+    leds.setMaxPower(2000);
+    for (uint8_t frame = 0; frame < 3; frame++) {
+        leds.setLEDColor(frame, 255, 255, 255, 255, 0, 0, 50);
+        leds.update();
+        backend.clearCapture();
+    }
+    bool refused = !leds.setEncoding(SPI_ENCODING_4BIT) && !leds.setBackend(nullptr) &&
+                   !leds.setPixelStorage(PIXEL_STORAGE_PALETTE8) && !leds.setWireChunkSize(0) &&
+                   !leds.reserve(200) && !leds.setNumLEDs(200);
+
+    plain.setLEDColor(3, 10, 20, 30, 0, 0, 0, 100);
+    refused = refused && !plain.setGamma(2.2f) && !plain.addPowerZone(0, 10, 100) &&
+              !plain.setColorCorrection(LEDColor(255, 128, 64)) && plain.getPixelBuffer().brightness == nullptr;
+    accepted = plain.setColorCorrection(LEDColor(200, 200, 200)) && accepted; // Fits the one table
+    SPI.setCaptureEnabled(false);
+    plain.update();
+    SPI.setCaptureEnabled(true);
+
+    uint32_t allocated = allocations - before;
+    if (allocated != 0 || !accepted || !refused) {
+        printf("FAIL: %u allocations after begin(); %s\n", allocated,
+               !accepted ? "a setter was refused" : !refused ? "an allocating setter was accepted" : "setters ok");
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks that the output side of a pipeline only sends published frames, newest first.
+///
+static bool verifyPipeline() {
+    const uint16_t numLEDs = 24;
+    ShiftLED leds("GRB", numLEDs, MOSI);
+    if (!leds.enablePipeline()) {
+        printf("FAIL: pipeline rejected\n");
+        return false;
+    }
+    leds.begin();
+    leds.update(); // The first frame is always sent
+
+    // Pixels that were not published stay on the render side
+    leds.setLEDColor(3, 10, 20, 30);
+    SPI.clearCapture();
+    leds.update();
+    if (!SPI.getTransfers().empty()) {
+        printf("FAIL: unpublished pixels were sent\n");
+        return false;
+    }
+
+    // Of two published frames only the newest is sent, and drawing continues on top of the first
+    leds.publish();
+    leds.setLEDColor(5, 40, 50, 60);
+    leds.publish();
+    SPI.clearCapture();
+    leds.update();
+    std::vector<uint8_t> decoded;
+    ShiftLEDDecoder decoder(SPI_ENCODING_8BIT);
+    decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), decoded);
+    if (decoded.size() != numLEDs * 3u || decoded[3 * 3] != 20 || decoded[5 * 3] != 50) {
+        printf("FAIL: pipeline sent %u bytes\n", (unsigned)decoded.size());
+        return false;
+    }
+
+    // Palette storage keeps shared state the output side would read while it is drawn
+    leds.end();
+    if (leds.setPixelStorage(PIXEL_STORAGE_PALETTE8) || leds.getPixelStorage() != PIXEL_STORAGE_DIRECT) {
+        printf("FAIL: pipeline switched to palette storage\n");
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Renders on one thread while another sends, and checks that no frame is torn or sent out of order.
+///
+static bool stressPipeline(bool async) {
+    const uint16_t numLEDs = 48;
+    const uint32_t frames = 20000;
+    ShiftLEDMockBackend backend; // Must outlive the strip using it
+    ShiftLED leds("GRB", numLEDs, MOSI);
+    if (async) leds.setBackend(&backend);
+    leds.enablePipeline();
+    leds.begin();
+    leds.update(); // Flush the initial black frame
+
+    std::atomic<bool> done(false);
+    std::thread render([&]() {
+        for (uint32_t k = 1; k <= frames; k++) {
+            // Every LED carries the frame number; a torn frame mixes two of them
+            for (uint16_t i = 0; i < numLEDs; i++) {
+                leds.setLEDColor(i, k & 0xFF, k >> 8, (uint8_t)(i ^ k));
+                // Let the output side run mid-frame, also on a single core
+                if (i == numLEDs / 2 && (k & 3) == 0) std::this_thread::yield();
+            }
+            leds.publish();
+        }
+        done = true;
+    });
+
+    uint32_t sent = 0, torn = 0, last = 0;
+    bool ordered = true;
+    bool finished = false;
+    std::vector<uint8_t> decoded;
+    ShiftLEDDecoder decoder(SPI_ENCODING_8BIT);
+    while (!finished) {
+        finished = done; // One more frame after the last one was published
+        SPI.clearCapture();
+        uint32_t sentBefore = backend.getFrameCount();
+        if (async) {
+            leds.updateAsync();
+            while (leds.isBusy()) {}
+        } else {
+            leds.update();
+        }
+
+        // Nothing new was published; give the render side its turn
+        bool sentFrame = async ? backend.getFrameCount() != sentBefore : !SPI.getTransfers().empty();
+        if (!sentFrame) {
+            std::this_thread::yield();
+            continue;
+        }
+        decoded.clear();
+        if (async) {
+            decoder.decode(backend.getLastFrame().data(), backend.getLastFrame().size(), decoded);
+        } else {
+            decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), decoded);
+        }
+
+        // GRB on the wire: the high byte of the frame number, then the low byte
+        uint32_t k = (decoded[0] << 8) | decoded[1];
+        for (uint16_t i = 0; i < numLEDs; i++) {
+            if ((uint32_t)((decoded[i * 3] << 8) | decoded[i * 3 + 1]) != k || decoded[i * 3 + 2] != (uint8_t)(i ^ k)) {
+                torn++;
+                break;
+            }
+        }
+        if (k <= last) ordered = false;
+        last = k;
+        sent++;
+    }
+    render.join();
+
+    if (torn != 0 || !ordered || last != frames) {
+        printf("FAIL: pipeline sent %u frames, %u torn, last %u of %u\n", sent, torn, last, frames);
+        return false;
+    }
+    printf("Pipeline (%s): %u of %u frames sent, none torn\n", async ? "DMA" : "SPI", sent, frames);
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks the integer color conversions and the whole-buffer pixel kernels against scalar references.
+///
+static bool verifyEffects(PixelStorage storage) {
+    const LEDColor red(255, 0, 0);
+    LEDColor c1 = hsvToColor(0, 255, 255), c2 = hslToColor(0, 255, 128), c3 = hslToColor(99, 0, 255);
+    LEDColor c4 = hsvToColor(171, 0, 77);
+    if (c1.red != 255 || c1.green != 0 || c1.blue != 0 || c2.red != 255 || c2.green != 0 || c2.blue != 0 ||
+        c3.red != 255 || c3.green != 255 || c3.blue != 255 || c4.red != 77 || c4.green != 77 || c4.blue != 77) {
+        printf("FAIL: HSV/HSL conversion\n");
+        return false;
+    }
+
+    // 37 GRB LEDs leave a partial word at the end of the buffer
+    const uint16_t numLEDs = 37;
+    const size_t length = numLEDs * 3;
+    ShiftLED leds("GRB", numLEDs, MOSI);
+    leds.begin();
+    uint8_t base[length], other[length], expected[length];
+    for (size_t i = 0; i < length; i++) {
+        base[i] = (i * 89 + 31) & 0xFF;
+        other[i] = (i * 57 + 200) & 0xFF;
+    }
+
+    // Direct storage checks every byte; palette storage only needs the colors to survive the round trip
+    const PixelBuffer buffer = leds.getPixelBuffer();
+    if (storage == PIXEL_STORAGE_DIRECT) {
+        leds.setPixels(0, base, numLEDs, PIXEL_FORMAT_NATIVE);
+        leds.fadeToBlack(77);
+        for (size_t i = 0; i < length; i++) expected[i] = (base[i] * (256 - 77)) >> 8;
+        if (memcmp(buffer.data, expected, length) != 0) {
+            printf("FAIL: fadeToBlack differs from the scalar reference\n");
+            return false;
+        }
+
+        leds.setPixels(0, base, numLEDs, PIXEL_FORMAT_NATIVE);
+        leds.blendPixels(5, other, 30, 100);
+        memcpy(expected, base, length);
+        for (size_t i = 0; i < 30 * 3; i++) expected[15 + i] = (base[15 + i] * 156 + other[i] * 100) >> 8;
+        if (memcmp(buffer.data, expected, length) != 0) {
+            printf("FAIL: blendPixels differs from the scalar reference\n");
+            return false;
+        }
+
+        leds.setPixels(0, base, numLEDs, PIXEL_FORMAT_NATIVE);
+        leds.addPixels(0, other, numLEDs);
+        for (size_t i = 0; i < length; i++) expected[i] = (base[i] + other[i] > 255) ? 255 : base[i] + other[i];
+        if (memcmp(buffer.data, expected, length) != 0) {
+            printf("FAIL: addPixels differs from the scalar reference\n");
+            return false;
+        }
+
+        leds.blendPixels(0, other, numLEDs, 255);
+        if (memcmp(buffer.data, other, length) != 0) {
+            printf("FAIL: blendPixels with alpha 255 does not replace the pixels\n");
+            return false;
+        }
+
+        // The running power sum follows the kernels
+        ShiftLED reference("GRB", numLEDs, MOSI);
+        reference.setPixels(0, other, numLEDs, PIXEL_FORMAT_NATIVE);
+        if (leds.estimatePowerConsumption() != reference.estimatePowerConsumption()) {
+            printf("FAIL: power estimate not updated after blendPixels\n");
+            return false;
+        }
+    }
+
+    ShiftLED faded("GRB", numLEDs, MOSI);
+    faded.setPixelStorage(storage);
+    faded.begin();
+    faded.fillGradient(0, numLEDs, red, LEDColor(0, 0, 255));
+    faded.fadeToBlack(128);
+    SPI.clearCapture();
+    faded.update();
+    std::vector<uint8_t> decoded;
+    ShiftLEDDecoder decoder(SPI_ENCODING_8BIT);
+    decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), decoded);
+    if (decoded.size() != length || decoded[0] != 0 || decoded[1] != 127 || decoded[length - 1] != 127 ||
+        decoded[length - 2] != 0) {
+        printf("FAIL: faded gradient sends %u/%u ... %u/%u\n", decoded[0], decoded[1], decoded[length - 2],
+               decoded[length - 1]);
+        return false;
+    }
+
+    faded.fillRainbow(0, numLEDs, 0);
+    SPI.clearCapture();
+    faded.update();
+    decoded.clear();
+    decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), decoded);
+    LEDColor third = hsvToColor(((uint32_t)12 << 24) / numLEDs >> 16, 255, 255);
+    if (decoded[0] != 0 || decoded[1] != 255 || decoded[2] != 0 ||
+        decoded[36] != third.green || decoded[37] != third.red || decoded[38] != third.blue) {
+        printf("FAIL: rainbow sends %u/%u/%u at LED 0\n", decoded[0], decoded[1], decoded[2]);
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Appends an Adalight frame of RGB pixels.
+///
+static void appendAdalight(std::vector<uint8_t>& out, const uint8_t* pixels, uint16_t count, bool corrupt = false) {
+    uint8_t high = (count - 1) >> 8, low = (count - 1) & 0xFF;
+    const uint8_t header[] = {'A', 'd', 'a', high, low, (uint8_t)(high ^ low ^ 0x55 ^ (corrupt ? 1 : 0))};
+    out.insert(out.end(), header, header + 6);
+    out.insert(out.end(), pixels, pixels + count * 3);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Appends a TPM2 packet.
+///
+static void appendTPM2(std::vector<uint8_t>& out, uint8_t type, const uint8_t* payload, uint16_t size,
+                       uint8_t end = 0x36) {
+    const uint8_t header[] = {0xC9, type, (uint8_t)(size >> 8), (uint8_t)(size & 0xFF)};
+    out.insert(out.end(), header, header + 4);
+    out.insert(out.end(), payload, payload + size);
+    out.push_back(end);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Runs the receiver until it has consumed the stream; returns the number of frames it sent.
+///
+static uint32_t drainReceiver(ShiftLEDReceiver& receiver, ShiftLEDMockStream& stream) {
+    uint32_t frames = 0;
+    while (stream.available() > 0) {
+        if (receiver.run()) frames++;
+    }
+    return frames;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks that a strip shows the given RGB pixels, sent in GRB order.
+///
+static bool checkReceived(const char* name, const uint8_t* pixels, uint16_t count) {
+    std::vector<uint8_t> decoded;
+    ShiftLEDDecoder decoder(SPI_ENCODING_8BIT);
+    decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), decoded);
+    if (decoded.size() != count * 3u) {
+        printf("FAIL: %s sent %u bytes, expected %u\n", name, (unsigned)decoded.size(), count * 3u);
+        return false;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        const uint8_t* p = pixels + i * 3;
+        if (decoded[i * 3] != p[1] || decoded[i * 3 + 1] != p[0] || decoded[i * 3 + 2] != p[2]) {
+            printf("FAIL: %s LED %u is %u/%u/%u\n", name, i, decoded[i * 3], decoded[i * 3 + 1], decoded[i * 3 + 2]);
+            return false;
+        }
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks Adalight and TPM2 framing, reordering, the corrupt and dropped frame counts, that a stalled frame
+/// is not sent, that a corrupt TPM2 frame never reaches the strip, and that pipelined frames are published.
+///
+static bool verifyReceiver(PixelStorage storage) {
+    const uint16_t numLEDs = 20;
+    uint8_t pixels[30 * 3];
+    for (uint16_t i = 0; i < 30 * 3; i++) pixels[i] = i * 7 + 3;
+
+    ShiftLED leds("GRB", numLEDs, MOSI);
+    leds.setPixelStorage(storage);
+    leds.begin();
+    ShiftLEDMockStream stream;
+    ShiftLEDReceiver receiver(leds, stream);
+    receiver.begin();
+    if (stream.getOutput() != std::vector<uint8_t>({'A', 'd', 'a', '\n'})) {
+        printf("FAIL: receiver did not send the Adalight handshake\n");
+        return false;
+    }
+
+    // Noise, a corrupt header and a valid frame, arriving a few bytes at a time
+    std::vector<uint8_t> input = {0x00, 'A', 'd', 0x13};
+    appendAdalight(input, pixels, numLEDs, true);
+    appendAdalight(input, pixels, numLEDs);
+    stream.feed(input.data(), input.size());
+    stream.setChunkSize(7);
+    SPI.clearCapture();
+    if (drainReceiver(receiver, stream) != 1 || receiver.getCorruptFrames() != 1 ||
+        !checkReceived("Adalight", pixels, numLEDs)) {
+        printf("FAIL: Adalight frame not received (%u corrupt)\n", receiver.getCorruptFrames());
+        return false;
+    }
+
+    // A TPM2 frame longer than the strip is cut off; command packets and a bad end byte are not shown
+    input.clear();
+    appendTPM2(input, 0xC0, pixels, 5);
+    appendTPM2(input, 0xDA, pixels + 3, 30 * 3 - 3);
+    appendTPM2(input, 0xDA, pixels, numLEDs * 3, 0x00);
+    stream.feed(input.data(), input.size());
+    SPI.clearCapture();
+    if (drainReceiver(receiver, stream) != 1 || receiver.getCorruptFrames() != 2 ||
+        !checkReceived("TPM2", pixels + 3, numLEDs)) {
+        printf("FAIL: TPM2 frame not received (%u corrupt)\n", receiver.getCorruptFrames());
+        return false;
+    }
+
+    // A stalled frame is dropped and the next one starts cleanly
+    input.clear();
+    appendAdalight(input, pixels, numLEDs);
+    stream.feed(input.data(), 30);
+    drainReceiver(receiver, stream);
+    delay(200);
+    receiver.run();
+    stream.feed(input.data(), input.size());
+    SPI.clearCapture();
+    if (receiver.getDroppedFrames() != 1 || drainReceiver(receiver, stream) != 1 ||
+        !checkReceived("Adalight after timeout", pixels, numLEDs)) {
+        printf("FAIL: stalled frame not dropped (%u dropped)\n", receiver.getDroppedFrames());
+        return false;
+    }
+
+    // GRB input matches the strip and is copied without reordering
+    uint8_t native[numLEDs * 3];
+    for (uint16_t i = 0; i < numLEDs; i++) {
+        native[i * 3] = pixels[i * 3 + 1];
+        native[i * 3 + 1] = pixels[i * 3];
+        native[i * 3 + 2] = pixels[i * 3 + 2];
+    }
+    receiver.setInputOrder("GRB");
+    input.clear();
+    appendTPM2(input, 0xDA, native, sizeof(native));
+    stream.feed(input.data(), input.size());
+    SPI.clearCapture();
+    if (drainReceiver(receiver, stream) != 1 || !checkReceived("TPM2 native", pixels, numLEDs) ||
+        receiver.getFrameCount() != 4) {
+        printf("FAIL: native TPM2 frame not received\n");
+        return false;
+    }
+
+    // A corrupt TPM2 frame is staged and never reaches the strip; a short frame only changes its own LEDs
+    uint8_t other[numLEDs * 3];
+    uint8_t expected[numLEDs * 3];
+    memcpy(expected, pixels, sizeof(expected));
+    for (uint16_t i = 0; i < numLEDs * 3; i++) other[i] = 255 - pixels[i];
+    for (uint16_t i = 0; i < 5; i++) {
+        expected[i * 3] = other[i * 3 + 1];
+        expected[i * 3 + 1] = other[i * 3];
+        expected[i * 3 + 2] = other[i * 3 + 2];
+    }
+    input.clear();
+    appendTPM2(input, 0xDA, other, sizeof(other), 0x00);
+    appendTPM2(input, 0xDA, other, 5 * 3);
+    stream.feed(input.data(), input.size());
+    uint32_t frames = drainReceiver(receiver, stream);
+    SPI.clearCapture();
+    leds.markPixelsChanged(0, numLEDs);
+    leds.update();
+    if (frames != 1 || receiver.getCorruptFrames() != 3 ||
+        !checkReceived("short TPM2 after a corrupt frame", expected, numLEDs)) {
+        printf("FAIL: corrupt TPM2 frame reached the strip (%u corrupt)\n", receiver.getCorruptFrames());
+        return false;
+    }
+
+    // A stalled Adalight frame is not sent
+    receiver.setInputOrder("RGB");
+    input.clear();
+    appendAdalight(input, other, numLEDs);
+    stream.feed(input.data(), 30);
+    SPI.clearCapture();
+    drainReceiver(receiver, stream);
+    delay(200);
+    receiver.run();
+    if (receiver.getDroppedFrames() != 2 || !SPI.getCapture().empty() || receiver.getFrameCount() != 5) {
+        printf("FAIL: stalled Adalight frame was sent (%u dropped)\n", receiver.getDroppedFrames());
+        return false;
+    }
+
+    // With the pipeline on, received frames are published to the output side
+    ShiftLED piped("GRB", numLEDs, MOSI);
+    piped.setPixelStorage(storage);
+    piped.enablePipeline();
+    piped.begin();
+    ShiftLEDMockStream pipedStream;
+    ShiftLEDReceiver pipedReceiver(piped, pipedStream);
+    pipedReceiver.begin();
+    input.clear();
+    appendAdalight(input, pixels, numLEDs);
+    appendTPM2(input, 0xDA, other, sizeof(other));
+    pipedStream.feed(input.data(), 6 + numLEDs * 3);
+    SPI.clearCapture();
+    if (drainReceiver(pipedReceiver, pipedStream) != 1 || !checkReceived("pipelined Adalight", pixels, numLEDs)) {
+        printf("FAIL: pipelined Adalight frame not sent\n");
+        return false;
+    }
+    pipedStream.feed(input.data() + 6 + numLEDs * 3, input.size() - 6 - numLEDs * 3);
+    SPI.clearCapture();
+    if (drainReceiver(pipedReceiver, pipedStream) != 1 || !checkReceived("pipelined TPM2", other, numLEDs)) {
+        printf("FAIL: pipelined TPM2 frame not sent\n");
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks the frame timing and power limiter statistics on the simulated clock.
+///
+static bool verifyStats() {
+#ifdef SHIFT_LED_STATS
+    ShiftLED leds("GRB", 10, MOSI);
+    leds.begin();
+    leds.setMaxPowerPerLED(100);
+    leds.setDirtyTracking(false); // Every frame sends all LEDs
+    leds.setMaxPower(500); // Half of what the white strip would draw
+    leds.setAllLEDs(255, 255, 255);
+    leds.resetStats();
+
+    for (uint8_t frame = 0; frame < 5; frame++) {
+        leds.setLEDColor(0, 255, 255, 255);
+        leds.update();
+        delay(10);
+    }
+
+    ShiftLEDStats stats = leds.getStats();
+    if (stats.frames != 5 || stats.wireBytes != 5u * (10 * 24 + 1) || stats.clampCount != 5 ||
+        stats.lastClampDepth != 128 || stats.maxPower_mW > 500 || stats.minPower_mW != stats.maxPower_mW) {
+        printf("FAIL: statistics report %u frames, %u bytes, %u clamps of depth %u, %u-%u mW\n", stats.frames,
+               (unsigned)stats.wireBytes, stats.clampCount, stats.lastClampDepth, stats.minPower_mW,
+               stats.maxPower_mW);
+        return false;
+    }
+
+    // 240 bytes at 8 MHz take 240 µs; the line idled through delay(10), so there is no reset wait
+    if (stats.lastTime_us[STATS_PHASE_TRANSFER] < 240 || stats.lastTime_us[STATS_PHASE_TRANSFER] > 250 ||
+        stats.lastTime_us[STATS_PHASE_LATCH] > 10 || stats.fps < 90 || stats.fps > 100) {
+        printf("FAIL: statistics report %u us transfer, %u us latch, %.1f FPS\n",
+               stats.lastTime_us[STATS_PHASE_TRANSFER], stats.lastTime_us[STATS_PHASE_LATCH], stats.fps);
+        return false;
+    }
+#endif
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Render callback that takes longer than a 100 FPS frame.
+///
+static void slowRender(ShiftLED& leds, uint32_t frameNumber) {
+    leds.setLEDColor(9, frameNumber, 0, 0);
+    delay(25);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Checks the frame rate, keyframe interpolation and frame dropping of the animator on the simulated clock.
+///
+static bool verifyAnimator() {
+    ShiftLED leds("GRB", 10, MOSI);
+    leds.begin();
+    SPI.setCaptureEnabled(false);
+
+    const LEDKeyframe fade[] = {
+        {0, LEDColor(0, 0, 0), 255},
+        {500, LEDColor(200, 100, 0), 255}
+    };
+    ShiftLEDAnimator animator(leds, 100);
+    int8_t track = animator.addTrack(0, 5, fade, 2);
+    unsigned long start_ms = millis();
+
+    while (millis() - start_ms < 250) animator.run();
+    uint8_t red = leds.getPixelBuffer()[0][1]; // GRB
+    while (millis() - start_ms < 1000) animator.run();
+
+    SPI.setCaptureEnabled(true);
+    if (animator.getFrameCount() < 99 || animator.getFrameCount() > 101 || animator.getDroppedFrames() != 0 ||
+        animator.getMissedDeadlines() != 0) {
+        printf("FAIL: animator sent %u frames (%u dropped, %u late), expected 100\n", animator.getFrameCount(),
+               animator.getDroppedFrames(), animator.getMissedDeadlines());
+        return false;
+    }
+    if (red < 95 || red > 105 || animator.isTrackActive(track) || leds.getPixelBuffer()[4][1] != 200) {
+        printf("FAIL: animator track is at red %u halfway, expected 100\n", red);
+        return false;
+    }
+
+    // A single keyframe is held, even with a time and looping; times that go backwards are rejected
+    const LEDKeyframe hold[] = {{500, LEDColor(0, 0, 70), 255}};
+    const LEDKeyframe backwards[] = {{0, LEDColor(0, 0, 0), 255}, {300, LEDColor(0, 0, 0), 255},
+                                     {200, LEDColor(0, 0, 0), 255}};
+    track = animator.addTrack(6, 2, hold, 1, EASING_LINEAR, true);
+    SPI.setCaptureEnabled(false);
+    start_ms = millis();
+    while (millis() - start_ms < 50) animator.run();
+    SPI.setCaptureEnabled(true);
+    if (track < 0 || animator.isTrackActive(track) || leds.getPixelBuffer()[7][2] != 70 ||
+        animator.addTrack(0, 5, backwards, 3) != -1) {
+        printf("FAIL: single keyframe shows blue %u\n", leds.getPixelBuffer()[7][2]);
+        return false;
+    }
+
+    // Rendering takes 25 ms per 10 ms frame: slots are dropped instead of queued
+    ShiftLEDAnimator overloaded(leds, 100);
+    overloaded.addRenderCallback(slowRender);
+    SPI.setCaptureEnabled(false);
+    start_ms = millis();
+    while (millis() - start_ms < 1000) overloaded.run();
+    SPI.setCaptureEnabled(true);
+    if (overloaded.getFrameCount() > 45 || overloaded.getDroppedFrames() < 50 || overloaded.getMissedDeadlines() == 0) {
+        printf("FAIL: overloaded animator sent %u frames (%u dropped)\n", overloaded.getFrameCount(),
+               overloaded.getDroppedFrames());
+        return false;
+    }
+
+    // Tracks outlast the 71.6 minute micros() wrap, and pipelined frames are published before they are sent
+    ShiftLED piped("GRB", 2, MOSI);
+    piped.enablePipeline();
+    piped.begin();
+    const LEDKeyframe slow[] = {{0, LEDColor(0, 0, 0), 255}, {5000000, LEDColor(200, 0, 0), 255}};
+    const LEDKeyframe cycle[] = {{0, LEDColor(0, 0, 0), 255}, {1000, LEDColor(0, 0, 200), 255}};
+    ShiftLEDAnimator longRun(piped, 100);
+    start_ms = millis();
+    int8_t once = longRun.addTrack(0, 1, slow, 2);
+    longRun.addTrack(1, 1, cycle, 2, EASING_LINEAR, true);
+    SPI.setCaptureEnabled(false);
+    longRun.run();
+    for (uint32_t s = 0; s < 4500; s++) {
+        hostAdvanceNanos(1000000000ull);
+        longRun.run();
+    }
+    SPI.setCaptureEnabled(true);
+    SPI.clearCapture();
+    hostAdvanceNanos(500000000ull);
+    longRun.run();
+    std::vector<uint8_t> decoded;
+    ShiftLEDDecoder decoder(SPI_ENCODING_8BIT);
+    decoder.decode(SPI.getCapture().data(), SPI.getCapture().size(), decoded);
+    // The frame time is at most one period before now; blue steps through the loop in 5 ms steps
+    unsigned long elapsed_ms = millis() - start_ms;
+    if (decoded.size() != 6 || decoded[1] < (elapsed_ms - 20) / 25000 || decoded[1] > elapsed_ms / 25000 ||
+        (elapsed_ms % 1000 - decoded[5] * 5u + 1000) % 1000 > 20) {
+        printf("FAIL: after %lu ms the animator sends red %u and blue %u\n", elapsed_ms,
+               decoded.size() == 6 ? decoded[1] : 0, decoded.size() == 6 ? decoded[5] : 0);
+        return false;
+    }
+    SPI.setCaptureEnabled(false);
+    for (uint32_t s = 0; s < 500; s++) {
+        hostAdvanceNanos(1000000000ull);
+        longRun.run();
+    }
+    SPI.setCaptureEnabled(true);
+    if (longRun.isTrackActive(once) || piped.getPixelBuffer()[0][1] != 200) {
+        printf("FAIL: 83 minute track did not finish\n");
+        return false;
+    }
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Times the per-strip operations at one strip length; returns false if a streamed chunk takes longer to encode
+/// than to send.
+///
+static bool benchmarkStrip(uint32_t numLEDs, uint32_t budget) {
+    uint32_t iterations = budget / numLEDs > 3 ? budget / numLEDs : 3;
+
+    ShiftLED leds("GRBW", numLEDs, MOSI);
+    leds.begin();
+    leds.setDirtyTracking(false); // Time full frames
+    leds.setMaxPower(numLEDs * 100u);
+    SPI.setCaptureEnabled(false);
+
+    report("setAllLEDs", numLEDs, measure_ns(iterations, [&](uint32_t i) {
+        leds.setAllLEDs(i, 255 - i, i * 3, 17);
+    }));
+
+    report("setLEDColor (whole strip)", numLEDs, measure_ns(iterations, [&](uint32_t i) {
+        for (uint32_t led = 0; led < numLEDs; led++) {
+            leds.setLEDColor(led, led + i, 255 - led, i, 17);
+        }
+    }));
+
+    // Per-pixel rainbow with float HSV, as effects were written before the integer kernels
+    report("rainbow (float, per LED)", numLEDs, measure_ns(iterations, [&](uint32_t i) {
+        for (uint32_t led = 0; led < numLEDs; led++) {
+            float hue = fmodf((i + led * 360.0f / numLEDs), 360.0f) / 60.0f;
+            float x = 1.0f - fabsf(fmodf(hue, 2.0f) - 1.0f);
+            float r = 0, g = 0, b = 0;
+            switch ((int)hue) {
+                case 0: r = 1; g = x; break;
+                case 1: r = x; g = 1; break;
+                case 2: g = 1; b = x; break;
+                case 3: g = x; b = 1; break;
+                case 4: r = x; b = 1; break;
+                default: r = 1; b = x; break;
+            }
+            leds.setLEDColor(led, r * 255, g * 255, b * 255);
+        }
+    }));
+
+    report("fillRainbow", numLEDs, measure_ns(iterations, [&](uint32_t i) {
+        leds.fillRainbow(0, numLEDs, i);
+    }));
+
+    report("fadeToBlack", numLEDs, measure_ns(iterations, [&](uint32_t) {
+        leds.fadeToBlack(8);
+    }));
+
+    std::vector<uint8_t> layer((size_t)numLEDs * leds.getColorComponentCount());
+    for (size_t i = 0; i < layer.size(); i++) layer[i] = i;
+    report("blendPixels", numLEDs, measure_ns(iterations, [&](uint32_t i) {
+        leds.blendPixels(0, layer.data(), numLEDs, i);
+    }));
+
+    report("addPixels", numLEDs, measure_ns(iterations, [&](uint32_t) {
+        leds.addPixels(0, layer.data(), numLEDs);
+    }));
+
+    report("estimatePowerConsumption", numLEDs, measure_ns(iterations * 16, [&](uint32_t) {
+        sink = leds.estimatePowerConsumption();
+    }));
+
+    report("power recompute", numLEDs, measure_ns(iterations, [&](uint32_t) {
+        leds.markPixelsChanged(0, numLEDs);
+        sink = leds.estimatePowerConsumption();
+    }));
+
+    const SPIEncoding encodings[] = {SPI_ENCODING_8BIT, SPI_ENCODING_4BIT, SPI_ENCODING_3BIT};
+    const char* names[] = {"update (8-bit)", "update (4-bit)", "update (3-bit)"};
+    for (uint8_t e = 0; e < 3; e++) {
+        // The encoding sizes the wire buffer, so it can only change between end() and begin()
+        leds.end();
+        leds.setEncoding(encodings[e]);
+        leds.begin();
+        report(names[e], numLEDs, measure_ns(iterations, [&](uint32_t) {
+            leds.update();
+        }));
+    }
+
+    // Same frames encoded 64 LEDs at a time just ahead of the transfer; single-wire chips stream through an
+    // asynchronous backend. The chunks complete at once, so this times the encoding alone.
+    const uint16_t chunkLEDs = 64;
+    ShiftLEDMockBackend backend;
+    backend.setWireTimeEnabled(false);
+    ShiftLED streamed("GRBW", numLEDs, MOSI);
+    streamed.setBackend(&backend);
+    streamed.setWireChunkSize(chunkLEDs);
+    streamed.begin();
+    streamed.setDirtyTracking(false);
+    streamed.setMaxPower(numLEDs * 100u);
+    streamed.setAllLEDs(1, 254, 3, 17);
+    double streamed_ns = measure_ns(iterations, [&](uint32_t) {
+        backend.clearCapture();
+        streamed.update();
+    });
+    report("update (8-bit, streamed)", numLEDs, streamed_ns);
+
+    // Each chunk must be encoded before the previous one has left the wire, or the line idles long enough to latch
+    double chunkEncode_us = streamed_ns / numLEDs * chunkLEDs / 1000;
+    double chunkWire_us = chunkLEDs * streamed.getColorComponentCount() * 8 * 8 * 1e6 / backend.getClock();
+    printf("%-28s %8u LEDs %11.2f us encode %7.2f us on the wire\n", "streamed chunk", chunkLEDs, chunkEncode_us,
+           chunkWire_us);
+    if (chunkEncode_us >= chunkWire_us) {
+        printf("FAIL: a chunk takes longer to encode than to send\n");
+        return false;
+    }
+
+    SPI.setCaptureEnabled(true);
+    return true;
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Times receiving Adalight frames from a stream, with and without reordering.
+///
+static void benchmarkReceiver(uint16_t numLEDs, uint32_t budget) {
+    uint32_t iterations = budget / numLEDs > 3 ? budget / numLEDs : 3;
+
+    ShiftLED leds("GRB", numLEDs, MOSI);
+    leds.begin();
+    SPI.setCaptureEnabled(false);
+
+    std::vector<uint8_t> pixels(numLEDs * 3u), frame;
+    for (size_t i = 0; i < pixels.size(); i++) pixels[i] = i;
+    appendAdalight(frame, pixels.data(), numLEDs);
+
+    const char* orders[] = {"RGB", "GRB"};
+    const char* names[] = {"receive Adalight (reorder)", "receive Adalight (direct)"};
+    for (uint8_t o = 0; o < 2; o++) {
+        ShiftLEDMockStream stream;
+        ShiftLEDReceiver receiver(leds, stream);
+        receiver.setInputOrder(orders[o]);
+        for (uint32_t i = 0; i < iterations; i++) stream.feed(frame.data(), frame.size());
+        stream.setChunkSize(64); // A typical UART receive buffer
+        report(names[o], numLEDs, measure_ns(iterations, [&](uint32_t) {
+            while (!receiver.run()) {}
+        }));
+    }
+
+    SPI.setCaptureEnabled(true);
+}
+
+///---------------------------------------------------------------------------------------------------------------------
+/// @brief Times color string parsing.
+///
+static void benchmarkParsing(uint32_t budget) {
+    const char* strings[] = {"#FF5733", "#F53", "2700K", "darkolivegreen"};
+    for (const char* text : strings) {
+        size_t length = strlen(text);
+        char name[48];
+        snprintf(name, sizeof(name), "parseLEDColor %s", text);
+        report(name, 0, measure_ns(budget, [&](uint32_t) {
+            LEDColor color;
+            parseLEDColor(text, length, color);
+            sink = color.red + color.warmWhite;
+        }));
+    }
+}
+
+int main(int argc, char** argv) {
+    bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+    Serial.setOutputEnabled(false);
+
+    const SPIEncoding encodings[] = {SPI_ENCODING_8BIT, SPI_ENCODING_4BIT, SPI_ENCODING_3BIT};
+    for (SPIEncoding encoding : encodings) {
+        if (!verifyEncoding(encoding)) return 1;
+    }
+    if (!verifyColorParsing()) return 1;
+    if (!verifyColorCorrection()) return 1;
+    if (!verifyDirtyTracking()) return 1;
+    if (!verifyPowerSum(PIXEL_STORAGE_DIRECT) || !verifyPowerSum(PIXEL_STORAGE_PALETTE4)) return 1;
+    if (!verifyAsync()) return 1;
+    if (!verifyPalette(PIXEL_STORAGE_PALETTE8) || !verifyPalette(PIXEL_STORAGE_PALETTE4)) return 1;
+    if (!verifyController()) return 1;
+    if (!verifyAnimator()) return 1;
+    if (!verifyTiming("WS2812", 0xF8, 0xC0, 300)) return 1;
+    if (!verifyTiming("WS2812B", 0xFC, 0xE0, 280)) return 1;
+    if (!verifyTiming("SK6812", 0xF8, 0xC0, 80)) return 1;
+    if (!verifyClocked()) return 1;
+    if (!verifyPowerZones()) return 1;
+    if (!verifyStreaming()) return 1;
+    if (!verifyCapacity()) return 1;
+    if (!verifyNoAllocation()) return 1;
+    if (!verifyPipeline() || !stressPipeline(false) || !stressPipeline(true)) return 1;
+    if (!verifyEffects(PIXEL_STORAGE_DIRECT) || !verifyEffects(PIXEL_STORAGE_PALETTE8)) return 1;
+    if (!verifyReceiver(PIXEL_STORAGE_DIRECT) || !verifyReceiver(PIXEL_STORAGE_PALETTE8)) return 1;
+    if (!verifyStats()) return 1;
+    printf("Waveform verification passed\n\n");
+
+    uint32_t budget = quick ? 200000 : 20000000;
+    const uint32_t quickLengths[] = {10, 300, 4096};
+    const uint32_t fullLengths[] = {10, 100, 1000, 10000, 65535, 100000};
+    if (quick) {
+        for (uint32_t numLEDs : quickLengths) {
+            if (!benchmarkStrip(numLEDs, budget)) return 1;
+        }
+    } else {
+        for (uint32_t numLEDs : fullLengths) {
+            if (!benchmarkStrip(numLEDs, budget)) return 1;
+        }
+    }
+    benchmarkReceiver(300, budget);
+    benchmarkParsing(quick ? 10000 : 1000000);
+
+    return 0;
+}